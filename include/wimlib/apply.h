@@ -6,6 +6,7 @@
 #include "wimlib/list.h"
 #include "wimlib/progress.h"
 #include "wimlib/types.h"
+#include "wimlib/util.h"
 #include "wimlib.h"
 
 /* These can be treated as counts (for required_features) or booleans (for
@@ -66,12 +67,40 @@ struct apply_ctx {
 	/* Features supported by the extraction mode (with booleans)  */
 	struct wim_features supported_features;
 
+	/* Booleans derived from supported_features, cached here because they
+	 * are invariant for the whole extraction but are tested in per-stream
+	 * and per-chunk loops.  */
+	bool supports_hard_links;
+	bool supports_named_streams;
+	bool symlinks_as_unix;	/* symlinks must be created natively (e.g. via
+				   symlink()) rather than as reparse points  */
+
 	/* The members below should not be used outside of extract.c  */
 	const struct apply_operations *apply_ops;
+	/* Copy of apply_ops->will_back_from_wim, hoisted here so the
+	 * per-stream planning loop makes one load instead of chasing two
+	 * pointers to discover that most backends leave it NULL.  */
+	int (*will_back_from_wim)(struct wim_dentry *, struct apply_ctx *);
 	u64 next_progress;
+	/* progress_step(progress.extract.total_bytes), computed once when the
+	 * total is finalized at the end of the planning phase.  */
+	u64 progress_step;
 	unsigned long invalid_sequence;
+	/* Scratch buffer for fixing up invalid filenames, grown as needed and
+	 * reused across dentries instead of being allocated per name.  */
+	u8 *name_scratch;
+	size_t name_scratch_cap;
 	unsigned long num_blobs_remaining;
 	struct list_head blob_list;
+	/* Array holding one entry per blob in 'blob_list', in list order.
+	 * Sorting the blobs into sequential read order works on this
+	 * contiguous array rather than on the linked list itself.  */
+	struct blob_descriptor **plan_blobs;
+	size_t num_plan_blobs;
+	size_t alloc_plan_blobs;
+	/* Arena backing the out-of-line blob extraction target arrays; freed
+	 * in one shot when the extraction context is destroyed.  */
+	struct arena target_arena;
 	const struct read_blob_callbacks *saved_cbs;
 	struct filedes tmpfile_fd;
 	tchar *tmpfile_name;
@@ -87,6 +87,13 @@ bsfw(machine_word_t v)
 		return bsf64(v);
 }
 
+/* Return the number of 1 bits in the input value.  */
+static forceinline unsigned
+popcount32(u32 v)
+{
+	return __builtin_popcount(v);
+}
+
 /* Return the log base 2 of 'n', rounded up to the nearest integer. */
 static forceinline unsigned
 ilog2_ceil(size_t n)
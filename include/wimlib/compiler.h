@@ -56,6 +56,17 @@
 /* Declare that the annotated function should *not* be inlined.  */
 #define noinline		__attribute__((noinline))
 
+/* Declare that the annotated function is "pure": its return value depends
+ * only on its arguments and on memory they point to, and it has no side
+ * effects.  This lets the compiler eliminate or hoist repeated calls, e.g.
+ * re-reads of the same header field inside a loop.  */
+#define attrib_pure		__attribute__((pure))
+
+/* Declare that the annotated function is on a hot path, so the compiler
+ * should optimize it more aggressively and group it with other hot code for
+ * better instruction cache locality.  */
+#define attrib_hot		__attribute__((hot))
+
 /* Functionally the same as 'noinline', but documents that the reason for not
  * inlining is to prevent the annotated function from being inlined into a
  * recursive function, thereby increasing its stack usage.  */
@@ -19,6 +19,9 @@ do_canonicalize_path(const tchar *in, tchar *out);
 tchar *
 canonicalize_wim_path(const tchar *wim_path);
 
+void
+canonicalize_wim_path_into(tchar *out, const tchar *wim_path);
+
 /* is_any_path_separator() - characters treated as path separators in WIM path
  * specifications and capture configuration files (the former will be translated
  * to WIM_PATH_SEPARATOR; the latter will be translated to
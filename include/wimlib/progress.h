@@ -34,28 +34,44 @@ int
 report_error(wimlib_progress_func_t progfunc,
 	     void *progctx, int error_code, const tchar *path);
 
+/*
+ * Compute the rate-limiting step for byte-count based progress messages: the
+ * next message is sent after another 1/128 of the total, but at least after
+ * another 5000000 bytes, have been processed.  Callers whose total byte count
+ * is fixed can compute this once instead of per message.
+ */
+static inline u64
+progress_step(u64 total_bytes)
+{
+	return max(min(total_bytes / 128, (u64)5000000), (u64)1);
+}
+
 /* Rate-limiting of byte-count based progress messages: update *next_progress_p
  * to the value that completed_bytes needs to reach before the next progress
- * message will be sent.  */
+ * message will be sent.  @step must be progress_step(total_bytes).  */
 static inline void
-set_next_progress(u64 completed_bytes, u64 total_bytes, u64 *next_progress_p)
+set_next_progress_step(u64 completed_bytes, u64 total_bytes, u64 step,
+		       u64 *next_progress_p)
 {
 	if (*next_progress_p < total_bytes) {
-		/*
-		 * Send the next message as soon as:
-		 *	- another 1/128 of the total has been processed;
-		 *	- OR another 5000000 bytes have been processed;
-		 *	- OR all bytes have been processed.
-		 */
-		*next_progress_p = min(min(completed_bytes + total_bytes / 128,
-					   completed_bytes + 5000000),
-				       total_bytes);
+		/* Send the next message after another @step bytes, or when all
+		 * bytes have been processed, whichever comes first.  */
+		*next_progress_p = min(completed_bytes + step, total_bytes);
 	} else {
 		/* Last message has been sent.  */
 		*next_progress_p = ~0;
 	}
 }
 
+/* As above, but for callers whose total byte count can change between
+ * messages, so the step must be recomputed each time.  */
+static inline void
+set_next_progress(u64 completed_bytes, u64 total_bytes, u64 *next_progress_p)
+{
+	set_next_progress_step(completed_bytes, total_bytes,
+			       progress_step(total_bytes), next_progress_p);
+}
+
 /* Windows: temporarily remove the stream name from the path  */
 static inline tchar *
 progress_get_streamless_path(const tchar *path)
@@ -30,6 +30,7 @@
 
 #include "wimlib/compiler.h"
 #include "wimlib/types.h"
+#include "wimlib/unaligned.h"
 
 /* Note: the data types in this header are prefixed with wimlib_ to avoid
  * conflicts with the same types being defined in the libntfs-3g headers.  */
@@ -75,6 +76,25 @@ typedef struct {
 #define wimlib_SE_RM_CONTROL_VALID		0x4000
 #define wimlib_SE_SELF_RELATIVE			0x8000
 
+/* Bitwise OR of all defined control flags.  A control word with any other bit
+ * set is invalid, so "only legal bits?" checks reduce to a single mask test:
+ * (control & ~wimlib_SE_VALID_MASK) == 0  */
+#define wimlib_SE_VALID_MASK			0xFF3F
+
+/* Any ACL present?  */
+#define wimlib_SE_ACL_PRESENT_MASK		(wimlib_SE_DACL_PRESENT | \
+						 wimlib_SE_SACL_PRESENT)
+
+/* Any ACL auto-inherited?  */
+#define wimlib_SE_AUTO_INHERITED_MASK		(wimlib_SE_DACL_AUTO_INHERITED | \
+						 wimlib_SE_SACL_AUTO_INHERITED)
+
+/* Note: the structures below other than wimlib_SECURITY_DESCRIPTOR_RELATIVE
+ * are *not* marked packed, since their natural layout already matches the
+ * on-disk format (verified by sd_layout_checks() below).  Forcing 1-byte
+ * alignment would make the compiler assume unaligned fields everywhere and
+ * block whole-word loads.  */
+
 /* Windows NT security identifier (user or group)  */
 typedef struct {
 
@@ -85,7 +105,22 @@ typedef struct {
 	u8  identifier_authority[6];
 
 	le32 sub_authority[];
-} __attribute__((packed)) wimlib_SID;
+} wimlib_SID;
+
+/*
+ * Compare two SIDs for equality.  The fixed 8-byte header (revision,
+ * sub-authority count, and authority) is folded into one 64-bit compare,
+ * which rejects nearly all unequal pairs before the variable-length
+ * sub-authority array is examined.
+ */
+static inline bool
+wimlib_sid_equal(const wimlib_SID *a, const wimlib_SID *b)
+{
+	if (load_u64_unaligned(a) != load_u64_unaligned(b))
+		return false;
+	return !memcmp(a->sub_authority, b->sub_authority,
+		       (size_t)a->sub_authority_count * sizeof(le32));
+}
 
 /* Header of a Windows NT access control list  */
 typedef struct {
@@ -104,12 +139,91 @@ typedef struct {
 
 	/* padding  */
 	le16 sbz2;
-} __attribute__((packed)) wimlib_ACL;
+} wimlib_ACL;
+
+static attrib_pure inline u16
+acl_size(const wimlib_ACL *acl)
+{
+	return get_unaligned_le16((const u8 *)&acl->acl_size);
+}
+
+static attrib_pure inline u16
+acl_ace_count(const wimlib_ACL *acl)
+{
+	return get_unaligned_le16((const u8 *)&acl->ace_count);
+}
+
+/*
+ * Accessors for the multibyte fields of the security descriptor structures.
+ * The on-disk structures are little-endian and not necessarily aligned, so
+ * always go through get_unaligned_le{16,32}(); this is both correct on
+ * strict-alignment targets and lets the compiler emit a single (possibly
+ * byteswapped) load rather than reassembling the value byte-by-byte.
+ */
+
+static attrib_pure inline u16
+sd_control(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd)
+{
+	return get_unaligned_le16((const u8 *)&sd->control);
+}
+
+static attrib_pure inline u32
+sd_owner_offset(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd)
+{
+	return get_unaligned_le32((const u8 *)&sd->owner_offset);
+}
+
+static attrib_pure inline u32
+sd_group_offset(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd)
+{
+	return get_unaligned_le32((const u8 *)&sd->group_offset);
+}
+
+static attrib_pure inline u32
+sd_sacl_offset(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd)
+{
+	return get_unaligned_le32((const u8 *)&sd->sacl_offset);
+}
+
+static attrib_pure inline u32
+sd_dacl_offset(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd)
+{
+	return get_unaligned_le32((const u8 *)&sd->dacl_offset);
+}
 
 #define wimlib_ACCESS_ALLOWED_ACE_TYPE		0
 #define wimlib_ACCESS_DENIED_ACE_TYPE		1
 #define wimlib_SYSTEM_AUDIT_ACE_TYPE		2
 
+/* Number of ACE types handled by wimlib; also the dispatch index for
+ * unrecognized types  */
+#define wimlib_ACE_TYPE_MAX			3
+
+/* ACE flags  */
+#define wimlib_OBJECT_INHERIT_ACE		0x01
+#define wimlib_CONTAINER_INHERIT_ACE		0x02
+#define wimlib_NO_PROPAGATE_INHERIT_ACE		0x04
+#define wimlib_INHERIT_ONLY_ACE			0x08
+#define wimlib_INHERITED_ACE			0x10
+#define wimlib_SUCCESSFUL_ACCESS_ACE_FLAG	0x40
+#define wimlib_FAILED_ACCESS_ACE_FLAG		0x80
+
+/* Inheritance-related ACE flags  */
+#define wimlib_ACE_INHERIT_FLAGS_MASK		(wimlib_OBJECT_INHERIT_ACE | \
+						 wimlib_CONTAINER_INHERIT_ACE | \
+						 wimlib_NO_PROPAGATE_INHERIT_ACE | \
+						 wimlib_INHERIT_ONLY_ACE | \
+						 wimlib_INHERITED_ACE)
+
+/* ACE flags meaningful only for system-audit ACEs  */
+#define wimlib_ACE_AUDIT_FLAGS_MASK		(wimlib_SUCCESSFUL_ACCESS_ACE_FLAG | \
+						 wimlib_FAILED_ACCESS_ACE_FLAG)
+
+/* Bitwise OR of all defined ACE flags, so "only legal bits?" checks reduce to
+ * a single mask test: (flags & ~wimlib_ACE_VALID_FLAGS_MASK) == 0  */
+#define wimlib_ACE_VALID_FLAGS_MASK		(wimlib_ACE_INHERIT_FLAGS_MASK | \
+						 wimlib_ACE_AUDIT_FLAGS_MASK)
+
 /* Header of a Windows NT access control entry  */
 typedef struct {
 	/* Type of ACE  */
@@ -120,27 +234,240 @@ typedef struct {
 
 	/* Size of the access control entry, including this header  */
 	le16 size;
-} __attribute__((packed)) wimlib_ACE_HEADER;
+} wimlib_ACE_HEADER;
+
+static attrib_pure inline u16
+ace_size(const wimlib_ACE_HEADER *hdr)
+{
+	return get_unaligned_le16((const u8 *)&hdr->size);
+}
+
+/*
+ * Map a raw ACE type byte to a dense dispatch index in
+ * [0, wimlib_ACE_TYPE_MAX].  The defined types are already densely numbered
+ * from 0, so this just clamps unknown types to wimlib_ACE_TYPE_MAX; a
+ * switch on the result compiles to a bounded jump table with a single
+ * default case for everything unrecognized.
+ */
+static attrib_pure inline unsigned
+ace_dispatch_index(const wimlib_ACE_HEADER *hdr)
+{
+	unsigned type = hdr->type;
+
+	return (type < wimlib_ACE_TYPE_MAX) ? type : wimlib_ACE_TYPE_MAX;
+}
+
+/*
+ * Advance to the next ACE in an ACL.  The whole 4-byte header is fetched with
+ * one unaligned load and the size extracted with a shift, so an ACE walk costs
+ * one load per entry rather than separate byte accesses; the next header is
+ * prefetched to hide the pointer-chase latency on SID-heavy ACLs.
+ */
+static inline const wimlib_ACE_HEADER *
+ace_next(const wimlib_ACE_HEADER *hdr)
+{
+	u32 w = get_unaligned_le32((const u8 *)hdr);
+	const wimlib_ACE_HEADER *next =
+		(const wimlib_ACE_HEADER *)((const u8 *)hdr + (w >> 16));
+
+	prefetchr(next);
+	return next;
+}
+
+/*
+ * Return the last ACE of an ACL, or NULL if it has none.  This is the entry
+ * point for reverse-order ACL walks, which can decide an allow/deny outcome
+ * in a single pass with no "already granted/denied" bookkeeping.  Since the
+ * on-disk format only links forward, the tail is located with one forward
+ * scan; callers that iterate repeatedly should cache per-ACE offsets from
+ * that scan.  The ACL must already have passed wimlib_acl_ok().
+ */
+static inline const wimlib_ACE_HEADER *
+wimlib_acl_last_ace(const wimlib_ACL *acl)
+{
+	const wimlib_ACE_HEADER *ace = (const wimlib_ACE_HEADER *)(acl + 1);
+	u16 count = acl_ace_count(acl);
+
+	if (count == 0)
+		return NULL;
+	for (u16 i = 1; i < count; i++)
+		ace = ace_next(ace);
+	return ace;
+}
 
 /* Windows NT access control entry to grant rights to a user or group  */
 typedef struct {
 	wimlib_ACE_HEADER hdr;
 	le32 mask;
 	wimlib_SID sid;
-} __attribute__((packed)) wimlib_ACCESS_ALLOWED_ACE;
+} wimlib_ACCESS_ALLOWED_ACE;
 
 /* Windows NT access control entry to deny rights to a user or group  */
 typedef struct {
 	wimlib_ACE_HEADER hdr;
 	le32 mask;
 	wimlib_SID sid;
-} __attribute__((packed)) wimlib_ACCESS_DENIED_ACE;
+} wimlib_ACCESS_DENIED_ACE;
 
 /* Windows NT access control entry to audit access to the object  */
 typedef struct {
 	wimlib_ACE_HEADER hdr;
 	le32 mask;
 	wimlib_SID sid;
-} __attribute__((packed)) wimlib_SYSTEM_AUDIT_ACE;
+} wimlib_SYSTEM_AUDIT_ACE;
+
+/*
+ * Compact in-memory form of an ACE for code that scans many ACEs after
+ * parsing.  The type and flags bytes are packed into one word and the SID is
+ * externalized to an index into a SID pool, so each entry is a fixed 12 bytes
+ * in native byte order --- roughly half the footprint of the variable-length
+ * on-disk form.  The on-disk wimlib_*_ACE structures above remain the only
+ * thing ever read from or written to a WIM.
+ */
+struct wimlib_ace_inmem {
+	u32 type_flags;		/* type in bits 0-7, flags in bits 8-15  */
+	u32 mask;
+	u32 sid_idx;		/* index into the caller's SID pool  */
+};
+
+/* The mask is at the same offset in all three ACE variants.  */
+static attrib_pure inline u32
+ace_mask(const wimlib_ACE_HEADER *hdr)
+{
+	return get_unaligned_le32((const u8 *)hdr +
+				  offsetof(wimlib_ACCESS_ALLOWED_ACE, mask));
+}
+
+static inline struct wimlib_ace_inmem
+ace_to_inmem(const wimlib_ACE_HEADER *hdr, u32 sid_idx)
+{
+	return (struct wimlib_ace_inmem) {
+		.type_flags = (u32)hdr->type | ((u32)hdr->flags << 8),
+		.mask = ace_mask(hdr),
+		.sid_idx = sid_idx,
+	};
+}
+
+/*
+ * Check that the four SID/ACL offsets of a security descriptor lie within the
+ * buffer.  The comparison results are OR-accumulated so the common all-valid
+ * case costs one branch rather than four.
+ */
+static inline bool
+wimlib_sd_offsets_ok(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd, size_t len)
+{
+	unsigned bad = ((size_t)sd_owner_offset(sd) > len) |
+		       ((size_t)sd_group_offset(sd) > len) |
+		       ((size_t)sd_sacl_offset(sd) > len) |
+		       ((size_t)sd_dacl_offset(sd) > len);
+
+	return !bad;
+}
+
+/* Validate the ACL at 'offset' within the security descriptor buffer,
+ * including a bounds-checked walk of its ACEs.  An offset of 0 means the ACL
+ * is not present, which is fine.  */
+static inline bool
+wimlib_acl_ok(const u8 *buf, size_t len, u32 offset)
+{
+	const wimlib_ACL *acl;
+	size_t pos, end;
+	u16 count;
+
+	if (offset == 0)
+		return true;
+	if (offset > len || len - offset < sizeof(wimlib_ACL))
+		return false;
+	acl = (const wimlib_ACL *)(buf + offset);
+	/* acl_size covers the ACL header itself; a smaller value would make
+	 * 'end - pos' below underflow and defeat the ACE bounds checks.  */
+	if (acl_size(acl) < sizeof(wimlib_ACL))
+		return false;
+	end = offset + acl_size(acl);
+	if (end > len)
+		return false;
+	pos = offset + sizeof(wimlib_ACL);
+	count = acl_ace_count(acl);
+	for (u16 i = 0; i < count; i++) {
+		const wimlib_ACE_HEADER *ace;
+		u16 size;
+
+		if (end - pos < sizeof(wimlib_ACE_HEADER))
+			return false;
+		ace = (const wimlib_ACE_HEADER *)(buf + pos);
+		size = ace_size(ace);
+		if (size < sizeof(wimlib_ACE_HEADER) || size > end - pos)
+			return false;
+		pos += size;
+	}
+	return true;
+}
+
+/* Does this security descriptor have the revision-1, self-relative form that
+ * practically every descriptor in a WIM has?  */
+static attrib_pure inline bool
+wimlib_sd_is_v1_selfrel(const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd)
+{
+	return sd->revision == 1 && (sd_control(sd) & wimlib_SE_SELF_RELATIVE);
+}
+
+/* Structural validation specialized for the dominant revision-1,
+ * self-relative case; the caller has already established those invariants
+ * (and a minimum length of sizeof(wimlib_SECURITY_DESCRIPTOR_RELATIVE)), so
+ * only the control bits, the offsets, and the ACL walks remain to be
+ * checked.  */
+static attrib_hot inline bool
+wimlib_sd_validate_v1_selfrel(const void *_buf, size_t len)
+{
+	const u8 *buf = _buf;
+	const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd = _buf;
+
+	if (sd_control(sd) & ~wimlib_SE_VALID_MASK)
+		return false;
+	if (!wimlib_sd_offsets_ok(sd, len))
+		return false;
+	return wimlib_acl_ok(buf, len, sd_dacl_offset(sd)) &&
+	       wimlib_acl_ok(buf, len, sd_sacl_offset(sd));
+}
+
+/* Single-pass structural validation of a self-relative security descriptor:
+ * header size, control bits, offset ranges, and a bounds-checked walk of the
+ * DACL and SACL.  Dispatches to the specialized path for the common
+ * revision-1, self-relative form.  */
+static attrib_hot inline bool
+wimlib_sd_validate(const void *_buf, size_t len)
+{
+	const u8 *buf = _buf;
+	const wimlib_SECURITY_DESCRIPTOR_RELATIVE *sd = _buf;
+
+	if (len < sizeof(*sd))
+		return false;
+	if (likely(wimlib_sd_is_v1_selfrel(sd)))
+		return wimlib_sd_validate_v1_selfrel(buf, len);
+	if (sd_control(sd) & ~wimlib_SE_VALID_MASK)
+		return false;
+	if (!wimlib_sd_offsets_ok(sd, len))
+		return false;
+	return wimlib_acl_ok(buf, len, sd_dacl_offset(sd)) &&
+	       wimlib_acl_ok(buf, len, sd_sacl_offset(sd));
+}
+
+/* Verify that the natural struct layouts match the on-disk format.  (In a
+ * dummy function because STATIC_ASSERT() cannot appear at file scope in
+ * C99.)  */
+static inline void
+sd_layout_checks(void)
+{
+	STATIC_ASSERT(sizeof(wimlib_SECURITY_DESCRIPTOR_RELATIVE) == 20);
+	STATIC_ASSERT(sizeof(wimlib_SID) == 8);
+	STATIC_ASSERT(offsetof(wimlib_SID, sub_authority) == 8);
+	STATIC_ASSERT(sizeof(wimlib_ACL) == 8);
+	STATIC_ASSERT(offsetof(wimlib_ACL, acl_size) == 2);
+	STATIC_ASSERT(sizeof(wimlib_ACE_HEADER) == 4);
+	STATIC_ASSERT(offsetof(wimlib_ACE_HEADER, size) == 2);
+	STATIC_ASSERT(sizeof(wimlib_ACCESS_ALLOWED_ACE) == 16);
+	STATIC_ASSERT(offsetof(wimlib_ACCESS_ALLOWED_ACE, mask) == 4);
+	STATIC_ASSERT(offsetof(wimlib_ACCESS_ALLOWED_ACE, sid) == 8);
+}
 
 #endif /* _WIMLIB_SECURITY_DESCRIPTOR_H */
@@ -80,6 +80,29 @@ memdup(const void *mem, size_t size);
 #define ALIGNED_MALLOC	wimlib_aligned_malloc
 #define ALIGNED_FREE	wimlib_aligned_free
 
+/*
+ * Arena (chunked bump) allocator, for many small allocations that all become
+ * unneeded at the same time.  Allocations are handed out from 64 KiB chunks
+ * and cannot be freed individually; the whole arena is freed at once with
+ * arena_destroy().  This avoids per-allocation malloc/free overhead and heap
+ * fragmentation, and keeps consecutively allocated objects contiguous.
+ */
+struct arena {
+	struct arena_chunk *chunks;	/* most recent chunk first  */
+};
+
+static inline void
+arena_init(struct arena *arena)
+{
+	arena->chunks = NULL;
+}
+
+void *
+arena_alloc(struct arena *arena, size_t size);
+
+void
+arena_destroy(struct arena *arena);
+
 /*******************
  * String utilities
  *******************/
@@ -57,6 +57,11 @@ struct WIMStruct {
 	 * enough, actually contains 0 images.  */
 	struct wim_image_metadata **image_metadata;
 
+	/* The allocated length of the 'image_metadata' array, in entries.
+	 * This is at least hdr.image_count; extra slack allows images to be
+	 * appended without reallocating the array every time.  */
+	unsigned image_metadata_capacity;
+
 	/* Information from the XML data of the WIM file.  This information is
 	 * also maintained for a WIMStruct not backed by a file.  */
 	struct wim_xml_info *xml_info;
@@ -113,6 +118,18 @@ struct WIMStruct {
 	u8 decompressor_ctype;
 	u32 decompressor_max_block_size;
 
+	/*
+	 * This is the cached buffer for reading chunks too large to fit on the
+	 * stack (e.g. chunks of solid resources), or NULL if no buffer is
+	 * cached yet.  Like the decompressor above, it is cached here so that
+	 * it can be reused when multiple resources with the same chunk size
+	 * are read from this WIM file.  chunk_buf_size is the chunk size the
+	 * buffer accommodates; the allocation itself is large enough for both
+	 * an uncompressed and a compressed chunk of that size.
+	 */
+	void *chunk_buf;
+	u32 chunk_buf_size;
+
 	/* Temporary field; use sparingly  */
 	void *private;
 
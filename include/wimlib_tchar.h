@@ -4,6 +4,10 @@
 /* Functions to act on "tchar" strings, which have a platform-dependent encoding
  * and character size. */
 
+/* 256-byte table for the ASCII fast path of totlower(); defined in util.c.
+ * Bytes outside 'A'-'Z' map to themselves.  */
+extern const unsigned char wimlib_ascii_tolower[256];
+
 #ifdef _WIN32
 #include <wchar.h>
 /*
@@ -33,7 +37,13 @@ typedef wchar_t tchar;
 #  define tscanf	swscanf
 #  define istalpha(c)	iswalpha((wchar_t)(c))
 #  define istspace(c)	iswspace((wchar_t)(c))
-#  define totlower(c)	towlower((wchar_t)(c))
+/* Lowercase a character, using a table lookup for ASCII (the overwhelmingly
+ * common case in paths) and falling back to the libc routine otherwise. */
+#  define totlower(c)						\
+	({ wchar_t _c = (c);					\
+	   (unsigned)_c < 0x80 ?				\
+		(wchar_t)wimlib_ascii_tolower[(unsigned)_c] :	\
+		towlower(_c); })
 #  define tstrcmp	wcscmp
 #  define tstrncmp	wcsncmp
 #  define tstrchr	wcschr
@@ -70,6 +80,8 @@ typedef wchar_t tchar;
 #  define trename	win32_rename_replacement
 #  define tglob		win32_wglob
 #else /* _WIN32 */
+#include <stddef.h>
+#include <strings.h>
 /*
  * For non-Windows builds, the "tchar" type will be one byte and will specify a
  * string encoded in UTF-8 with the additional possibility of surrogate
@@ -97,7 +109,12 @@ typedef char tchar;
 #  define tscanf	sscanf
 #  define istalpha(c)	isalpha((unsigned char)(c))
 #  define istspace(c)	isspace((unsigned char)(c))
-#  define totlower(c)	tolower((unsigned char)(c))
+/* Lowercase a character, using a table lookup for ASCII (the overwhelmingly
+ * common case in paths) and falling back to the libc routine otherwise. */
+#  define totlower(c)						\
+	({ unsigned char _c = (c);				\
+	   _c < 0x80 ? (char)wimlib_ascii_tolower[_c] :		\
+		       (char)tolower(_c); })
 #  define tstrcmp	strcmp
 #  define tstrncmp	strncmp
 #  define tstrchr	strchr
@@ -131,4 +148,149 @@ typedef char tchar;
 #  define tglob		glob
 #endif /* !_WIN32 */
 
+#if TCHAR_IS_UTF16LE && defined(__SSE2__)
+#include <emmintrin.h>
+#include <stdint.h>
+/*
+ * Compare 'n' tchars, optimized for the short UTF-16LE strings (filenames)
+ * that dominate WIM metadata.  Compares 8 code units per vector instead of
+ * making a wmemcmp() library call.  Same return-value contract as wmemcmp().
+ */
+static inline int
+tmemcmp_short(const tchar *a, const tchar *b, size_t n)
+{
+	while (n >= 8) {
+		__m128i va = _mm_loadu_si128((const __m128i *)a);
+		__m128i vb = _mm_loadu_si128((const __m128i *)b);
+		unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi16(va, vb)) ^ 0xFFFF;
+
+		if (m) {
+			size_t i = __builtin_ctz(m) >> 1;
+
+			return (int)a[i] - (int)b[i];
+		}
+		a += 8;
+		b += 8;
+		n -= 8;
+	}
+	for (size_t i = 0; i < n; i++)
+		if (a[i] != b[i])
+			return (int)a[i] - (int)b[i];
+	return 0;
+}
+/*
+ * Length of a null-terminated UTF-16LE string, 8 code units per vector.
+ * Aligned vector loads cannot cross a page boundary, so after the scalar
+ * alignment prologue the overreads past the terminator are harmless.
+ */
+static inline size_t
+tstrlen_fast(const tchar *s)
+{
+	const tchar *p = s;
+	const __m128i z = _mm_setzero_si128();
+
+	while ((uintptr_t)p & 15) {
+		if (*p == 0)
+			return p - s;
+		p++;
+	}
+	for (;;) {
+		__m128i v = _mm_load_si128((const __m128i *)p);
+		unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi16(v, z));
+
+		if (m)
+			return (p - s) + (__builtin_ctz(m) >> 1);
+		p += 8;
+	}
+}
+#undef tstrlen
+#  define tstrlen	tstrlen_fast
+
+/*
+ * Find the first occurrence of the code unit 'c' in the first 'n' units of
+ * 's', 8 units per vector.  Same contract as wmemchr().
+ */
+static inline tchar *
+tmemchr_fast(const tchar *s, tchar c, size_t n)
+{
+	const __m128i needle = _mm_set1_epi16(c);
+
+	for (; n >= 8; s += 8, n -= 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)s);
+		unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi16(v, needle));
+
+		if (m)
+			return (tchar *)s + (__builtin_ctz(m) >> 1);
+	}
+	for (; n; s++, n--)
+		if (*s == c)
+			return (tchar *)s;
+	return NULL;
+}
+#undef tmemchr
+#  define tmemchr	tmemchr_fast
+#else
+/* One-byte tchars (or no vector support): the libc routines are already
+ * well-optimized for this case. */
+#  define tmemcmp_short	tmemcmp
+#  define tstrlen_fast	tstrlen
+#  define tmemchr_fast	tmemchr
+#endif
+
+/*
+ * Copy a string whose length (in tchars, excluding the terminator) the caller
+ * already knows, e.g. from an earlier tstrlen().  Copies the terminator too
+ * and returns a pointer to it in 'dst' (like stpcpy()), so appends can
+ * continue from the result.  Unlike tstrcpy(), the source is not rescanned
+ * for the terminator.
+ */
+#define tstrcpy_n(dst, src, n)	((tchar *)tmempcpy((dst), (src), (n) + 1) - 1)
+
+/*
+ * Case-insensitive string comparison with an ASCII fast path: case is folded
+ * through the 256-byte table rather than a libc call per character.  Falls
+ * back to tstrcasecmp() on the first non-ASCII code unit, whose case folding
+ * is locale/encoding-dependent.
+ */
+static inline int
+tstrcasecmp_ascii(const tchar *a, const tchar *b)
+{
+	for (size_t i = 0;; i++) {
+		unsigned ca = (unsigned)a[i];
+		unsigned cb = (unsigned)b[i];
+
+		if ((ca | cb) >= 0x80)
+			return tstrcasecmp(a + i, b + i);
+		ca = wimlib_ascii_tolower[ca];
+		cb = wimlib_ascii_tolower[cb];
+		if (ca != cb)
+			return (int)ca - (int)cb;
+		if (ca == 0)
+			return 0;
+	}
+}
+
+/*
+ * Find the first occurrence in 's' of any character from 'set', which must
+ * consist only of ASCII characters (e.g. path separator sets like "/\\").
+ * A 128-bit membership bitmap is built from 'set' once, so the scan is one
+ * shift-and-test per character instead of the nested loop a generic
+ * strpbrk()/wcspbrk() implies.  Non-ASCII characters of 's' never match.
+ */
+static inline tchar *
+tstrpbrk_ascii(const tchar *s, const tchar *set)
+{
+	unsigned long long map[2] = { 0, 0 };
+
+	for (size_t i = 0; set[i]; i++)
+		map[((unsigned)set[i] >> 6) & 1] |= 1ULL << ((unsigned)set[i] & 63);
+	for (; *s; s++) {
+		unsigned c = (unsigned)*s;
+
+		if (c < 128 && ((map[c >> 6] >> (c & 63)) & 1))
+			return (tchar *)s;
+	}
+	return NULL;
+}
+
 #endif /* _WIMLIB_TCHAR_H */
@@ -516,14 +516,83 @@ sort_blob_list(struct list_head *blob_list, size_t list_head_offset,
 	return 0;
 }
 
+/* Compact sort key for blobs that all reside in the same WIM file; see
+ * sort_blob_list_by_sequential_order().  */
+struct sequential_sort_key {
+	u64 res_offset;
+	u64 blob_offset;
+	struct blob_descriptor *blob;
+};
+
+static int
+cmp_sequential_sort_keys(const void *p1, const void *p2)
+{
+	const struct sequential_sort_key *key1 = p1, *key2 = p2;
+
+	/* Sort by increasing resource offset, then by increasing offset in the
+	 * (solid) resource -- same order that cmp_blobs_by_sequential_order()
+	 * produces for blobs in a single WIM file.  */
+	if (key1->res_offset != key2->res_offset)
+		return cmp_u64(key1->res_offset, key2->res_offset);
+	return cmp_u64(key1->blob_offset, key2->blob_offset);
+}
+
 /* Sort the specified list of blobs in an order optimized for sequential
  * reading.  */
 int
 sort_blob_list_by_sequential_order(struct list_head *blob_list,
 				   size_t list_head_offset)
 {
-	return sort_blob_list(blob_list, list_head_offset,
-			      cmp_blobs_by_sequential_order);
+	struct sequential_sort_key *keys;
+	struct list_head *cur;
+	struct blob_descriptor *blob;
+	WIMStruct *wim = NULL;
+	size_t num_blobs = 0;
+	size_t i;
+
+	/* In the common case, every blob to read lies in the same WIM file.
+	 * Sorting then reduces to comparing resource and intra-resource
+	 * offsets, which can be copied into a compact key array so that the
+	 * O(N log N) comparisons stay within it instead of each touching a
+	 * blob_descriptor and a resource descriptor.  Mixed locations or
+	 * multiple WIM files (e.g. split WIMs or export) take the general
+	 * comparator instead.  */
+	list_for_each(cur, blob_list) {
+		blob = (struct blob_descriptor *)((u8 *)cur - list_head_offset);
+		if (blob->blob_location != BLOB_IN_WIM ||
+		    (wim != NULL && blob->rdesc->wim != wim))
+			return sort_blob_list(blob_list, list_head_offset,
+					      cmp_blobs_by_sequential_order);
+		wim = blob->rdesc->wim;
+		num_blobs++;
+	}
+
+	if (num_blobs <= 1)
+		return 0;
+
+	keys = MALLOC(num_blobs * sizeof(keys[0]));
+	if (keys == NULL)
+		return WIMLIB_ERR_NOMEM;
+
+	i = 0;
+	list_for_each(cur, blob_list) {
+		blob = (struct blob_descriptor *)((u8 *)cur - list_head_offset);
+		keys[i].res_offset = blob->rdesc->offset_in_wim;
+		keys[i].blob_offset = blob->offset_in_res;
+		keys[i].blob = blob;
+		i++;
+	}
+
+	qsort(keys, num_blobs, sizeof(keys[0]), cmp_sequential_sort_keys);
+
+	INIT_LIST_HEAD(blob_list);
+	for (i = 0; i < num_blobs; i++) {
+		list_add_tail((struct list_head *)
+				((u8 *)keys[i].blob + list_head_offset),
+			      blob_list);
+	}
+	FREE(keys);
+	return 0;
 }
 
 static int
@@ -1274,7 +1343,7 @@ after_blob_hashed(struct blob_descriptor *blob,
 		 * this blob to the duplicate and update the reference to this
 		 * blob (from a stream) to point to the duplicate.  The caller
 		 * is responsible for freeing @blob if needed.  */
-		if (duplicate_blob->size != blob->size) {
+		if (duplicate_blob->size != blob->size && wimlib_print_errors) {
 			tchar hash_str[SHA1_HASH_STRING_LEN];
 
 			sprint_hash(blob->hash, hash_str);
@@ -68,6 +68,7 @@
 #include "wimlib/endianness.h"
 #include "wimlib/metadata.h"
 #include "wimlib/paths.h"
+#include "wimlib/unaligned.h"
 
 /* On-disk format of a WIM dentry (directory entry), located in the metadata
  * resource for a WIM image.  */
@@ -1470,16 +1471,16 @@ err_free_dentry:
 static bool
 dentry_is_dot_or_dotdot(const struct wim_dentry *dentry)
 {
-	if (dentry->d_name_nbytes <= 4) {
-		if (dentry->d_name_nbytes == 4) {
-			if (dentry->d_name[0] == cpu_to_le16('.') &&
-			    dentry->d_name[1] == cpu_to_le16('.'))
-				return true;
-		} else if (dentry->d_name_nbytes == 2) {
-			if (dentry->d_name[0] == cpu_to_le16('.'))
-				return true;
-		}
-	}
+	/* Compare the whole name as a single 32-bit word rather than
+	 * character by character.  A 4-byte load is always in bounds here
+	 * because names are stored with a 2-byte null terminator, so a
+	 * 1-character name occupies 4 bytes.  */
+	if (dentry->d_name_nbytes == 2)
+		return load_le32_unaligned(dentry->d_name) ==
+		       cpu_to_le32('.');
+	if (dentry->d_name_nbytes == 4)
+		return load_le32_unaligned(dentry->d_name) ==
+		       cpu_to_le32('.' | ('.' << 16));
 	return false;
 }
 
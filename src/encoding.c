@@ -263,6 +263,28 @@ int
 utf8_to_utf16le(const char *in, size_t in_nbytes,
 		utf16lechar **out_ret, size_t *out_nbytes_ret)
 {
+	/* Fast path for the very common case of an all-ASCII string, which
+	 * converts to UTF-16LE by just widening each byte.  A byte >= 0x80
+	 * falls back to the generic converter.  */
+	size_t i;
+
+	for (i = 0; i < in_nbytes; i++)
+		if ((u8)in[i] >= 0x80)
+			break;
+	if (likely(i == in_nbytes)) {
+		utf16lechar *out = MALLOC((in_nbytes + 1) * 2);
+
+		if (unlikely(!out))
+			return WIMLIB_ERR_NOMEM;
+		for (i = 0; i < in_nbytes; i++)
+			out[i] = cpu_to_le16((u8)in[i]);
+		out[in_nbytes] = 0;
+		*out_ret = out;
+		if (out_nbytes_ret)
+			*out_nbytes_ret = in_nbytes * 2;
+		return 0;
+	}
+
 	return convert_string((const u8 *)in, in_nbytes,
 			      (u8 **)out_ret, out_nbytes_ret,
 			      WIMLIB_ERR_INVALID_UTF8_STRING,
@@ -273,6 +295,32 @@ int
 utf16le_to_utf8(const utf16lechar *in, size_t in_nbytes,
 		char **out_ret, size_t *out_nbytes_ret)
 {
+	/* Fast path for the very common case of an all-ASCII string, which
+	 * converts to UTF-8 by just dropping the high (zero) byte of each
+	 * code unit.  A code unit >= 0x80, or an odd input size, falls back
+	 * to the generic converter.  */
+	if (likely(!(in_nbytes & 1))) {
+		const size_t in_nchars = in_nbytes / 2;
+		size_t i;
+
+		for (i = 0; i < in_nchars; i++)
+			if (le16_to_cpu(in[i]) >= 0x80)
+				break;
+		if (likely(i == in_nchars)) {
+			char *out = MALLOC(in_nchars + 1);
+
+			if (unlikely(!out))
+				return WIMLIB_ERR_NOMEM;
+			for (i = 0; i < in_nchars; i++)
+				out[i] = le16_to_cpu(in[i]);
+			out[in_nchars] = '\0';
+			*out_ret = out;
+			if (out_nbytes_ret)
+				*out_nbytes_ret = in_nchars;
+			return 0;
+		}
+	}
+
 	return convert_string((const u8 *)in, in_nbytes,
 			      (u8 **)out_ret, out_nbytes_ret,
 			      WIMLIB_ERR_INVALID_UTF16_STRING,
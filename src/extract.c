@@ -47,6 +47,7 @@
 
 #include "wimlib/apply.h"
 #include "wimlib/assert.h"
+#include "wimlib/bitops.h"
 #include "wimlib/blob_table.h"
 #include "wimlib/dentry.h"
 #include "wimlib/encoding.h"
@@ -404,6 +405,21 @@ retry:
 	const char *tmpdir = getenv("TMPDIR");
 	if (!tmpdir)
 		tmpdir = P_tmpdir;
+
+#ifdef O_TMPFILE
+	/* On Linux, prefer an anonymous temporary file: it is created and
+	 * deleted in one syscall, never appears in the filesystem namespace,
+	 * and cannot be opened by pathname by anyone else.  */
+	raw_fd = open(tmpdir, O_TMPFILE | O_RDWR, 0600);
+	if (raw_fd >= 0) {
+		filedes_init(fd_ret, raw_fd);
+		*name_ret = NULL;
+		return 0;
+	}
+	/* Fall back to a named temporary file if the filesystem or kernel
+	 * doesn't support O_TMPFILE.  */
+#endif
+
 	name = MALLOC(strlen(tmpdir) + 1 + 6 + 6 + 1);
 	if (!name)
 		return WIMLIB_ERR_NOMEM;
@@ -443,7 +459,7 @@ extract_chunk(const struct blob_descriptor *blob, u64 offset,
 	bool last = (offset + size == blob->size);
 	int ret;
 
-	if (likely(ctx->supported_features.hard_links)) {
+	if (likely(ctx->supports_hard_links)) {
 		progress->extract.completed_bytes +=
 			(u64)size * blob->out_refcnt;
 		if (last)
@@ -468,9 +484,10 @@ extract_chunk(const struct blob_descriptor *blob, u64 offset,
 		if (ret)
 			return ret;
 
-		set_next_progress(progress->extract.completed_bytes,
-				  progress->extract.total_bytes,
-				  &ctx->next_progress);
+		set_next_progress_step(progress->extract.completed_bytes,
+				       progress->extract.total_bytes,
+				       ctx->progress_step,
+				       &ctx->next_progress);
 	}
 
 	if (unlikely(filedes_valid(&ctx->tmpfile_fd))) {
@@ -479,7 +496,8 @@ extract_chunk(const struct blob_descriptor *blob, u64 offset,
 		if (ret) {
 			ERROR_WITH_ERRNO("Error writing data to "
 					 "temporary file \"%"TS"\"",
-					 ctx->tmpfile_name);
+					 ctx->tmpfile_name ? ctx->tmpfile_name :
+						T("(anonymous)"));
 		}
 		return ret;
 	}
@@ -487,12 +505,47 @@ extract_chunk(const struct blob_descriptor *blob, u64 offset,
 	return call_continue_blob(blob, offset, chunk, size, ctx->saved_cbs);
 }
 
-/* Copy the blob's data from the temporary file to each of its targets.
+/* Feed the blob's data from the still-open temporary file to the callbacks
+ * for one extraction target.  */
+static int
+send_tmpfile_blob(struct filedes *tmpfile_fd,
+		  struct blob_descriptor *tmpfile_blob,
+		  const struct read_blob_callbacks *cbs)
+{
+	u8 buf[BUFFER_SIZE];
+	u64 offset = 0;
+	int ret;
+
+	ret = call_begin_blob(tmpfile_blob, cbs);
+	if (ret)
+		return ret;
+
+	while (offset != tmpfile_blob->size) {
+		size_t size = min(tmpfile_blob->size - offset,
+				  (u64)sizeof(buf));
+
+		ret = full_pread(tmpfile_fd, buf, size, offset);
+		if (ret) {
+			ERROR_WITH_ERRNO("Error reading temporary file");
+			break;
+		}
+		ret = call_continue_blob(tmpfile_blob, offset, buf, size, cbs);
+		if (ret)
+			break;
+		offset += size;
+	}
+
+	return call_end_blob(tmpfile_blob, ret, cbs);
+}
+
+/* Copy the blob's data from the temporary file to each of its targets.  The
+ * data is read back through the existing file descriptor rather than by
+ * reopening the file, which also allows the file to be anonymous (O_TMPFILE).
  *
  * This is executed only in the very uncommon case that a blob is being
  * extracted to more than MAX_OPEN_FILES targets!  */
 static int
-extract_from_tmpfile(const tchar *tmpfile_name,
+extract_from_tmpfile(struct filedes *tmpfile_fd,
 		     const struct blob_descriptor *orig_blob,
 		     const struct read_blob_callbacks *cbs)
 {
@@ -501,13 +554,11 @@ extract_from_tmpfile(const tchar *tmpfile_name,
 	int ret;
 
 	memcpy(&tmpfile_blob, orig_blob, sizeof(struct blob_descriptor));
-	tmpfile_blob.blob_location = BLOB_IN_FILE_ON_DISK;
-	tmpfile_blob.file_on_disk = (tchar *)tmpfile_name;
 	tmpfile_blob.out_refcnt = 1;
 
 	for (u32 i = 0; i < orig_blob->out_refcnt; i++) {
 		tmpfile_blob.inline_blob_extraction_targets[0] = targets[i];
-		ret = read_blob_with_cbs(&tmpfile_blob, cbs, false);
+		ret = send_tmpfile_blob(tmpfile_fd, &tmpfile_blob, cbs);
 		if (ret)
 			return ret;
 	}
@@ -541,13 +592,16 @@ end_extract_blob(struct blob_descriptor *blob, int status, void *_ctx)
 	}
 
 	if (unlikely(filedes_valid(&ctx->tmpfile_fd))) {
-		filedes_close(&ctx->tmpfile_fd);
 		if (!status)
-			status = extract_from_tmpfile(ctx->tmpfile_name, blob,
+			status = extract_from_tmpfile(&ctx->tmpfile_fd, blob,
 						      ctx->saved_cbs);
+		filedes_close(&ctx->tmpfile_fd);
 		filedes_invalidate(&ctx->tmpfile_fd);
-		tunlink(ctx->tmpfile_name);
-		FREE(ctx->tmpfile_name);
+		if (ctx->tmpfile_name) {
+			tunlink(ctx->tmpfile_name);
+			FREE(ctx->tmpfile_name);
+			ctx->tmpfile_name = NULL;
+		}
 		return status;
 	}
 
@@ -584,11 +638,23 @@ extract_blob_list(struct apply_ctx *ctx, const struct read_blob_callbacks *cbs)
 	if (ctx->extract_flags & WIMLIB_EXTRACT_FLAG_FROM_PIPE) {
 		return read_blobs_from_pipe(ctx, &wrapper_cbs);
 	} else {
-		int flags = VERIFY_BLOB_HASHES;
+		/* sort_planned_blobs() already put the blob list in sequential
+		 * reading order during the planning phase.  */
+		int flags = VERIFY_BLOB_HASHES | BLOB_LIST_ALREADY_SORTED;
 
 		if (ctx->extract_flags & WIMLIB_EXTRACT_FLAG_RECOVER_DATA)
 			flags |= RECOVER_DATA;
 
+#ifdef POSIX_FADV_SEQUENTIAL
+		/* The blobs are about to be read in (mostly) sequential
+		 * order, so let the kernel know that a larger readahead
+		 * window on the WIM file is worthwhile.  Ignore failures;
+		 * this is only a hint.  */
+		if (filedes_is_seekable(&ctx->wim->in_fd))
+			posix_fadvise(ctx->wim->in_fd.fd, 0, 0,
+				      POSIX_FADV_SEQUENTIAL);
+#endif
+
 		return read_blob_list(&ctx->blob_list,
 				      offsetof(struct blob_descriptor,
 					       extraction_list),
@@ -794,14 +860,14 @@ destroy_dentry_list(struct list_head *dentry_list)
 	}
 }
 
+/* The out-of-line blob extraction target arrays are allocated from
+ * ctx->target_arena and are freed all at once with the arena, so there is
+ * nothing to do per-blob here.  */
 static void
-destroy_blob_list(struct list_head *blob_list)
+destroy_blob_list(struct apply_ctx *ctx)
 {
-	struct blob_descriptor *blob;
-
-	list_for_each_entry(blob, blob_list, extraction_list)
-		if (blob->out_refcnt > ARRAY_LEN(blob->inline_blob_extraction_targets))
-			FREE(blob->blob_extraction_targets);
+	FREE(ctx->plan_blobs);
+	arena_destroy(&ctx->target_arena);
 }
 
 #ifdef _WIN32
@@ -810,38 +876,66 @@ static const utf16lechar replacement_char = cpu_to_le16(0xfffd);
 static const utf16lechar replacement_char = cpu_to_le16('?');
 #endif
 
+/* Bitmap of code points that cannot appear in an extracted filename: the null
+ * character and '/' everywhere, plus the control characters 0x01...0x1F and
+ * the characters  \ : * ? " < > |  on Windows.  All forbidden code points are
+ * below 0x80, so a character is valid if it is at least 0x80 or if its bit
+ * here is clear.  */
+static const u32 invalid_name_chars[128 / 32] = {
+#ifdef _WIN32
+	0xFFFFFFFF, 0xD4008404, 0x10000000, 0x10000000,
+#else
+	0x00000001, 0x00008000, 0x00000000, 0x00000000,
+#endif
+};
+
+static forceinline bool
+name_char_valid(u16 c)
+{
+	return c >= 0x80 ||
+	       !((invalid_name_chars[c / 32] >> (c % 32)) & 1);
+}
+
 static bool
 file_name_valid(utf16lechar *name, size_t num_chars, bool fix)
 {
-	size_t i;
-
-	if (num_chars == 0)
-		return true;
-	for (i = 0; i < num_chars; i++) {
-		switch (le16_to_cpu(name[i])) {
-	#ifdef _WIN32
-		case '\x01'...'\x1F':
-		case '\\':
-		case ':':
-		case '*':
-		case '?':
-		case '"':
-		case '<':
-		case '>':
-		case '|':
-	#endif
-		case '/':
-		case '\0':
-			if (fix)
-				name[i] = replacement_char;
-			else
-				return false;
+	if (fix) {
+		/* Rewrite mode: select between the original character and the
+		 * replacement unconditionally, keeping the loop branch-free.
+		 * This only ever runs on a scratch copy of the name.  */
+		for (size_t i = 0; i < num_chars; i++) {
+			u16 c = le16_to_cpu(name[i]);
+
+			name[i] = name_char_valid(c) ? name[i] :
+						       replacement_char;
 		}
+		return true;
 	}
 
+	for (size_t i = 0; i < num_chars; i++)
+		if (unlikely(!name_char_valid(le16_to_cpu(name[i]))))
+			return false;
+
 	return true;
 }
 
+/* Return a scratch buffer of at least @size bytes for filename fixups,
+ * growing the ctx-owned allocation geometrically when needed.  */
+static void *
+get_name_scratch(struct apply_ctx *ctx, size_t size)
+{
+	if (size > ctx->name_scratch_cap) {
+		size_t new_cap = max(size, ctx->name_scratch_cap * 2);
+		u8 *p = REALLOC(ctx->name_scratch, new_cap);
+
+		if (!p)
+			return NULL;
+		ctx->name_scratch = p;
+		ctx->name_scratch_cap = new_cap;
+	}
+	return ctx->name_scratch;
+}
+
 static int
 dentry_calculate_extraction_name(struct wim_dentry *dentry,
 				 struct apply_ctx *ctx)
@@ -911,7 +1005,21 @@ dentry_calculate_extraction_name(struct wim_dentry *dentry,
 
 out_replace:
 	{
-		utf16lechar utf16_name_copy[dentry->d_name_nbytes / 2];
+		utf16lechar *utf16_name_copy;
+		tchar *fixed_name;
+
+		/* One scratch block holds both the fixed-up UTF-16 name and
+		 * the final tchar name.  The tchar form of a name needs at
+		 * most three output units per UTF-16 code unit, and the
+		 * " (invalid filename #N)" suffix fits in the extra 64.  */
+		utf16_name_copy = get_name_scratch(ctx,
+					dentry->d_name_nbytes +
+					((3 * (dentry->d_name_nbytes / 2)) + 64)
+						* sizeof(tchar));
+		if (!utf16_name_copy)
+			return WIMLIB_ERR_NOMEM;
+		fixed_name = (tchar *)((u8 *)utf16_name_copy +
+				       dentry->d_name_nbytes);
 
 		memcpy(utf16_name_copy, dentry->d_name, dentry->d_name_nbytes);
 		file_name_valid(utf16_name_copy, dentry->d_name_nbytes / 2, true);
@@ -928,7 +1036,6 @@ out_replace:
 		tchar_nchars /= sizeof(tchar);
 
 		size_t fixed_name_num_chars = tchar_nchars;
-		tchar fixed_name[tchar_nchars + 50];
 
 		tmemcpy(fixed_name, tchar_name, tchar_nchars);
 		fixed_name_num_chars += tsprintf(fixed_name + tchar_nchars,
@@ -949,47 +1056,18 @@ skip_dentry:
 	return 0;
 }
 
-/*
- * Calculate the actual filename component at which each WIM dentry will be
- * extracted, with special handling for dentries that are unsupported by the
- * extraction backend or have invalid names.
- *
- * ctx->supported_features must be filled in.
- *
- * Possible error codes: WIMLIB_ERR_NOMEM, WIMLIB_ERR_INVALID_UTF16_STRING
- */
-static int
-dentry_list_calculate_extraction_names(struct list_head *dentry_list,
-				       struct apply_ctx *ctx)
+/* Prefetch the inode of the dentry following @dentry in the extraction list,
+ * so the dependent-load chain dentry -> d_inode -> i_streams[] of the next
+ * iteration overlaps with the current one's work.  */
+static inline void
+prefetch_next_dentry_inode(struct wim_dentry *dentry,
+			   struct list_head *dentry_list)
 {
-	struct list_head *prev, *cur;
+	struct list_head *next = dentry->d_extraction_list_node.next;
 
-	/* Can't use list_for_each_entry() because a call to
-	 * dentry_calculate_extraction_name() may delete the current dentry and
-	 * its children from the list.  */
-
-	prev = dentry_list;
-	for (;;) {
-		struct wim_dentry *dentry;
-		int ret;
-
-		cur = prev->next;
-		if (cur == dentry_list)
-			break;
-
-		dentry = list_entry(cur, struct wim_dentry, d_extraction_list_node);
-
-		ret = dentry_calculate_extraction_name(dentry, ctx);
-		if (ret)
-			return ret;
-
-		if (prev->next == cur)
-			prev = cur;
-		else
-			; /* Current dentry and its children (which follow in
-			     the list) were deleted.  prev stays the same.  */
-	}
-	return 0;
+	if (next != dentry_list)
+		prefetchr(list_entry(next, struct wim_dentry,
+				     d_extraction_list_node)->d_inode);
 }
 
 static int
@@ -1014,31 +1092,72 @@ dentry_resolve_streams(struct wim_dentry *dentry, int extract_flags,
 		return ret;
 	for (unsigned i = 0; i < inode->i_num_streams; i++) {
 		blob = stream_blob_resolved(&inode->i_streams[i]);
-		if (blob)
+		/* Only dirty the blob's cacheline if the counter actually
+		 * needs resetting; a blob shared by many streams is visited
+		 * here once per referencing stream.  */
+		if (blob && blob->out_refcnt != 0)
 			blob->out_refcnt = 0;
 	}
 	return 0;
 }
 
 /*
- * For each dentry to be extracted, resolve all streams in the corresponding
- * inode and set 'out_refcnt' in all referenced blob_descriptors to 0.
+ * Calculate the actual filename component at which each WIM dentry will be
+ * extracted, with special handling for dentries that are unsupported by the
+ * extraction backend or have invalid names.  For each dentry that will be
+ * extracted, this also resolves the streams in the corresponding inode, sets
+ * 'out_refcnt' in all referenced blob_descriptors to 0, and resets the
+ * inode's extraction alias list; formerly these were a second pass over the
+ * dentry list.
+ *
+ * ctx->supported_features must be filled in.
  *
- * Possible error codes: WIMLIB_ERR_RESOURCE_NOT_FOUND, WIMLIB_ERR_NOMEM.
+ * Possible error codes: WIMLIB_ERR_NOMEM, WIMLIB_ERR_INVALID_UTF16_STRING,
+ * WIMLIB_ERR_RESOURCE_NOT_FOUND
  */
 static int
-dentry_list_resolve_streams(struct list_head *dentry_list,
-			    struct apply_ctx *ctx)
+dentry_list_calculate_extraction_names(struct list_head *dentry_list,
+				       struct apply_ctx *ctx)
 {
-	struct wim_dentry *dentry;
-	int ret;
+	struct list_head *prev, *cur;
 
-	list_for_each_entry(dentry, dentry_list, d_extraction_list_node) {
-		ret = dentry_resolve_streams(dentry,
-					     ctx->extract_flags,
-					     ctx->wim->blob_table);
+	/* Can't use list_for_each_entry() because a call to
+	 * dentry_calculate_extraction_name() may delete the current dentry and
+	 * its children from the list.  */
+
+	prev = dentry_list;
+	for (;;) {
+		struct wim_dentry *dentry;
+		int ret;
+
+		cur = prev->next;
+		if (cur == dentry_list)
+			break;
+
+		dentry = list_entry(cur, struct wim_dentry, d_extraction_list_node);
+
+		prefetch_next_dentry_inode(dentry, dentry_list);
+		ret = dentry_calculate_extraction_name(dentry, ctx);
 		if (ret)
 			return ret;
+
+		if (prev->next == cur) {
+			/* The dentry will be extracted.  While it and its
+			 * inode are hot in cache, also resolve the inode's
+			 * streams and reset its extraction alias list (to be
+			 * rebuilt by dentry_list_ref_streams()); this was
+			 * formerly a separate pass over the whole list.  */
+			dentry->d_inode->i_first_extraction_alias = NULL;
+			ret = dentry_resolve_streams(dentry,
+						     ctx->extract_flags,
+						     ctx->wim->blob_table);
+			if (ret)
+				return ret;
+			prev = cur;
+		} else {
+			; /* Current dentry and its children (which follow in
+			     the list) were deleted.  prev stays the same.  */
+		}
 	}
 	return 0;
 }
@@ -1056,7 +1175,7 @@ ref_stream(struct wim_inode_stream *strm, struct wim_dentry *dentry,
 
 	/* Tally the size only for each actual extraction of the stream (not
 	 * additional hard links to the inode).  */
-	if (inode->i_visited && ctx->supported_features.hard_links)
+	if (inode->i_visited && ctx->supports_hard_links)
 		return 0;
 
 	ctx->progress.extract.total_bytes += blob->size;
@@ -1066,8 +1185,23 @@ ref_stream(struct wim_inode_stream *strm, struct wim_dentry *dentry,
 		return 0;
 
 	/* Add each blob to 'ctx->blob_list' only one time, regardless of how
-	 * many extraction targets it will have.  */
+	 * many extraction targets it will have.  Also append it to the
+	 * planning array (see struct apply_ctx).  */
 	if (blob->out_refcnt == 0) {
+		if (ctx->num_plan_blobs == ctx->alloc_plan_blobs) {
+			size_t new_alloc = max(ctx->alloc_plan_blobs * 2,
+					       (size_t)64);
+			struct blob_descriptor **new_blobs;
+
+			new_blobs = REALLOC(ctx->plan_blobs,
+					    new_alloc * sizeof(new_blobs[0]));
+			if (!new_blobs)
+				return WIMLIB_ERR_NOMEM;
+			ctx->plan_blobs = new_blobs;
+			ctx->alloc_plan_blobs = new_alloc;
+		}
+		ctx->plan_blobs[ctx->num_plan_blobs] = blob;
+		ctx->num_plan_blobs++;
 		list_add_tail(&blob->extraction_list, &ctx->blob_list);
 		ctx->num_blobs_remaining++;
 	}
@@ -1089,13 +1223,25 @@ ref_stream(struct wim_inode_stream *strm, struct wim_dentry *dentry,
 		}
 
 		if (blob->out_refcnt == alloc_blob_extraction_targets) {
-			alloc_blob_extraction_targets *= 2;
-			targets = REALLOC(prev_targets,
-					  alloc_blob_extraction_targets *
-					  sizeof(targets[0]));
+			/* Grow by relocating within the arena; the old array
+			 * is simply abandoned until the arena is freed.  This
+			 * avoids one heap allocation per overflowing blob.
+			 * The first out-of-line array gets 8 slots rather
+			 * than 2 * 3: most overflowing blobs are files with a
+			 * moderate hard link count, and 8 slots usually
+			 * avoids a second copy.  */
+			alloc_blob_extraction_targets =
+				max(alloc_blob_extraction_targets * 2,
+				    (size_t)8);
+			targets = arena_alloc(&ctx->target_arena,
+					      alloc_blob_extraction_targets *
+					      sizeof(targets[0]));
 			if (!targets)
 				return WIMLIB_ERR_NOMEM;
-			if (!prev_targets) {
+			if (prev_targets) {
+				memcpy(targets, prev_targets,
+				       blob->out_refcnt * sizeof(targets[0]));
+			} else {
 				memcpy(targets,
 				       blob->inline_blob_extraction_targets,
 				       sizeof(blob->inline_blob_extraction_targets));
@@ -1120,13 +1266,12 @@ ref_stream_if_needed(struct wim_dentry *dentry, struct wim_inode *inode,
 	case STREAM_TYPE_DATA:
 		if (stream_is_named(strm)) {
 			/* Named data stream  */
-			if (ctx->supported_features.named_data_streams)
+			if (ctx->supports_named_streams)
 				need_stream = true;
 		} else if (!(inode->i_attributes & (FILE_ATTRIBUTE_DIRECTORY |
 						    FILE_ATTRIBUTE_ENCRYPTED))
 			   && !(inode_is_symlink(inode)
-				&& !ctx->supported_features.reparse_points
-				&& ctx->supported_features.symlink_reparse_points))
+				&& ctx->symlinks_as_unix))
 		{
 			/*
 			 * Unnamed data stream.  Skip if any of the following is true:
@@ -1137,8 +1282,8 @@ ref_stream_if_needed(struct wim_dentry *dentry, struct wim_inode *inode,
 			 * - backend will extract the stream as externally
 			 *   backed from the WIM archive itself
 			 */
-			if (ctx->apply_ops->will_back_from_wim) {
-				int ret = (*ctx->apply_ops->will_back_from_wim)(dentry, ctx);
+			if (ctx->will_back_from_wim) {
+				int ret = (*ctx->will_back_from_wim)(dentry, ctx);
 				if (ret > 0) /* Error?  */
 					return ret;
 				if (ret < 0) /* Won't externally back?  */
@@ -1175,6 +1320,25 @@ static int
 dentry_ref_streams(struct wim_dentry *dentry, struct apply_ctx *ctx)
 {
 	struct wim_inode *inode = dentry->d_inode;
+
+	/* Fast path for the overwhelmingly common case: an ordinary file
+	 * whose only stream is the unnamed data stream.  This is equivalent
+	 * to what the general loop below decides, minus its dispatching.  */
+	if (likely(inode->i_num_streams == 1 &&
+		   inode->i_streams[0].stream_type == STREAM_TYPE_DATA &&
+		   !stream_is_named(&inode->i_streams[0]) &&
+		   !(inode->i_attributes & (FILE_ATTRIBUTE_DIRECTORY |
+					    FILE_ATTRIBUTE_ENCRYPTED |
+					    FILE_ATTRIBUTE_REPARSE_POINT)) &&
+		   !ctx->will_back_from_wim))
+	{
+		int ret = ref_stream(&inode->i_streams[0], dentry, ctx);
+		if (ret)
+			return ret;
+		inode->i_visited = 1;
+		return 0;
+	}
+
 	for (unsigned i = 0; i < inode->i_num_streams; i++) {
 		int ret = ref_stream_if_needed(dentry, inode,
 					       &inode->i_streams[i], ctx);
@@ -1188,7 +1352,11 @@ dentry_ref_streams(struct wim_dentry *dentry, struct apply_ctx *ctx)
 /*
  * Given a list of dentries to be extracted, build the list of blobs that need
  * to be extracted, and for each blob determine the streams to which that blob
- * will be extracted.
+ * will be extracted.  In the same pass, build each inode's list of dentries
+ * of that inode being extracted; the lists were emptied by
+ * dentry_list_calculate_extraction_names(), so each dentry just needs to be
+ * pushed onto
+ * its inode's list here while the inode is already in cache.
  *
  * This also initializes the extract progress info with byte and blob
  * information.
@@ -1202,6 +1370,11 @@ dentry_list_ref_streams(struct list_head *dentry_list, struct apply_ctx *ctx)
 	int ret;
 
 	list_for_each_entry(dentry, dentry_list, d_extraction_list_node) {
+		struct wim_inode *inode = dentry->d_inode;
+
+		prefetch_next_dentry_inode(dentry, dentry_list);
+		dentry->d_next_extraction_alias = inode->i_first_extraction_alias;
+		inode->i_first_extraction_alias = dentry;
 		ret = dentry_ref_streams(dentry, ctx);
 		if (ret)
 			return ret;
@@ -1211,47 +1384,57 @@ dentry_list_ref_streams(struct list_head *dentry_list, struct apply_ctx *ctx)
 	return 0;
 }
 
+/*
+ * Sort the blobs to be extracted into the order optimized for sequential
+ * reading of the underlying WIM resources.  The sort runs on the contiguous
+ * planning array built up by ref_stream(), rather than having
+ * sort_blob_list() walk the linked list into a temporary array at read time;
+ * ctx->blob_list is then rebuilt in the sorted order and read_blob_list() is
+ * told the list is already sorted.  Not used when extracting from a pipe,
+ * where the blob order is imposed by the sender.
+ */
 static void
-dentry_list_build_inode_alias_lists(struct list_head *dentry_list)
+sort_planned_blobs(struct apply_ctx *ctx)
 {
-	struct wim_dentry *dentry;
+	if (ctx->num_plan_blobs <= 1)
+		return;
 
-	list_for_each_entry(dentry, dentry_list, d_extraction_list_node)
-		dentry->d_inode->i_first_extraction_alias = NULL;
+	qsort(ctx->plan_blobs, ctx->num_plan_blobs, sizeof(ctx->plan_blobs[0]),
+	      cmp_blobs_by_sequential_order);
 
-	list_for_each_entry(dentry, dentry_list, d_extraction_list_node) {
-		dentry->d_next_extraction_alias = dentry->d_inode->i_first_extraction_alias;
-		dentry->d_inode->i_first_extraction_alias = dentry;
-	}
+	INIT_LIST_HEAD(&ctx->blob_list);
+	for (size_t i = 0; i < ctx->num_plan_blobs; i++)
+		list_add_tail(&ctx->plan_blobs[i]->extraction_list,
+			      &ctx->blob_list);
 }
 
 static void
 inode_tally_features(const struct wim_inode *inode,
 		     struct wim_features *features)
 {
-	if (inode->i_attributes & FILE_ATTRIBUTE_READONLY)
-		features->readonly_files++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_HIDDEN)
-		features->hidden_files++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_SYSTEM)
-		features->system_files++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_ARCHIVE)
-		features->archive_files++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_COMPRESSED)
-		features->compressed_files++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_ENCRYPTED) {
-		if (inode->i_attributes & FILE_ATTRIBUTE_DIRECTORY)
-			features->encrypted_directories++;
-		else
-			features->encrypted_files++;
-	}
-	if (inode->i_attributes & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
-		features->not_context_indexed_files++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_SPARSE_FILE)
-		features->sparse_files++;
+	const u32 attribs = inode->i_attributes;
+
+	/* Tally the purely attribute-derived counts branchlessly; these bits
+	 * are effectively random across a large image, so a conditional
+	 * increment per bit mispredicts constantly.  */
+	features->readonly_files += !!(attribs & FILE_ATTRIBUTE_READONLY);
+	features->hidden_files += !!(attribs & FILE_ATTRIBUTE_HIDDEN);
+	features->system_files += !!(attribs & FILE_ATTRIBUTE_SYSTEM);
+	features->archive_files += !!(attribs & FILE_ATTRIBUTE_ARCHIVE);
+	features->compressed_files += !!(attribs & FILE_ATTRIBUTE_COMPRESSED);
+	features->not_context_indexed_files +=
+		!!(attribs & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED);
+	features->sparse_files += !!(attribs & FILE_ATTRIBUTE_SPARSE_FILE);
+
+	const bool encrypted = (attribs & FILE_ATTRIBUTE_ENCRYPTED) != 0;
+	const bool directory = (attribs & FILE_ATTRIBUTE_DIRECTORY) != 0;
+
+	features->encrypted_directories += (encrypted & directory);
+	features->encrypted_files += (encrypted & !directory);
+
 	if (inode_has_named_data_stream(inode))
 		features->named_data_streams++;
-	if (inode->i_attributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+	if (attribs & FILE_ATTRIBUTE_REPARSE_POINT) {
 		features->reparse_points++;
 		if (inode_is_symlink(inode))
 			features->symlink_reparse_points++;
@@ -1292,77 +1475,73 @@ dentry_list_get_features(struct list_head *dentry_list,
 {
 	struct wim_dentry *dentry;
 
-	list_for_each_entry(dentry, dentry_list, d_extraction_list_node)
+	list_for_each_entry(dentry, dentry_list, d_extraction_list_node) {
+		prefetch_next_dentry_inode(dentry, dentry_list);
 		dentry_tally_features(dentry, features);
+	}
 
 	list_for_each_entry(dentry, dentry_list, d_extraction_list_node)
 		dentry->d_inode->i_visited = 0;
 }
 
+/* The simple feature warnings: if the count at @offset is nonzero in the
+ * required features but zero in the supported features, and none of
+ * @disable_flags are set, warn with @msg (which takes the count).  Feature
+ * mismatches with bespoke handling (errors under strict flags, compound
+ * conditions) stay open-coded in do_feature_check().
+ *
+ * Note: FILE_ATTRIBUTE_ARCHIVE is deliberately absent.  We're an archive
+ * program, so theoretically we can do what we want with it.  */
+static const struct feature_warning {
+	size_t offset;
+	int disable_flags;
+	const tchar *msg;
+} feature_warnings[] = {
+	{ offsetof(struct wim_features, encrypted_files), 0,
+	  T("Ignoring EFS-encrypted data of %lu files") },
+	{ offsetof(struct wim_features, named_data_streams), 0,
+	  T("Ignoring named data streams of %lu files") },
+	{ offsetof(struct wim_features, readonly_files),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_READONLY of %lu files") },
+	{ offsetof(struct wim_features, hidden_files),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_HIDDEN of %lu files") },
+	{ offsetof(struct wim_features, system_files),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_SYSTEM of %lu files") },
+	{ offsetof(struct wim_features, compressed_files),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_COMPRESSED of %lu files") },
+	{ offsetof(struct wim_features, not_context_indexed_files),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_NOT_CONTENT_INDEXED of %lu files") },
+	{ offsetof(struct wim_features, sparse_files),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_SPARSE_FILE of %lu files") },
+	{ offsetof(struct wim_features, encrypted_directories),
+	  WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES,
+	  T("Ignoring FILE_ATTRIBUTE_ENCRYPTED of %lu directories") },
+	{ offsetof(struct wim_features, hard_links), 0,
+	  T("Extracting %lu hard links as independent files") },
+};
+
 static int
 do_feature_check(const struct wim_features *required_features,
 		 const struct wim_features *supported_features,
 		 int extract_flags)
 {
-	/* Encrypted files.  */
-	if (required_features->encrypted_files &&
-	    !supported_features->encrypted_files)
-		WARNING("Ignoring EFS-encrypted data of %lu files",
-			required_features->encrypted_files);
-
-	/* Named data streams.  */
-	if (required_features->named_data_streams &&
-	    !supported_features->named_data_streams)
-		WARNING("Ignoring named data streams of %lu files",
-			required_features->named_data_streams);
-
-	/* File attributes.  */
-	if (!(extract_flags & WIMLIB_EXTRACT_FLAG_NO_ATTRIBUTES)) {
-
-		if (required_features->readonly_files &&
-		    !supported_features->readonly_files)
-			WARNING("Ignoring FILE_ATTRIBUTE_READONLY of %lu files",
-				required_features->readonly_files);
-
-		if (required_features->hidden_files &&
-		    !supported_features->hidden_files)
-			WARNING("Ignoring FILE_ATTRIBUTE_HIDDEN of %lu files",
-				required_features->hidden_files);
-
-		if (required_features->system_files &&
-		    !supported_features->system_files)
-			WARNING("Ignoring FILE_ATTRIBUTE_SYSTEM of %lu files",
-				required_features->system_files);
-
-		/* Note: Don't bother the user about FILE_ATTRIBUTE_ARCHIVE.
-		 * We're an archive program, so theoretically we can do what we
-		 * want with it.  */
-
-		if (required_features->compressed_files &&
-		    !supported_features->compressed_files)
-			WARNING("Ignoring FILE_ATTRIBUTE_COMPRESSED of %lu files",
-				required_features->compressed_files);
-
-		if (required_features->not_context_indexed_files &&
-		    !supported_features->not_context_indexed_files)
-			WARNING("Ignoring FILE_ATTRIBUTE_NOT_CONTENT_INDEXED of %lu files",
-				required_features->not_context_indexed_files);
-
-		if (required_features->sparse_files &&
-		    !supported_features->sparse_files)
-			WARNING("Ignoring FILE_ATTRIBUTE_SPARSE_FILE of %lu files",
-				required_features->sparse_files);
-
-		if (required_features->encrypted_directories &&
-		    !supported_features->encrypted_directories)
-			WARNING("Ignoring FILE_ATTRIBUTE_ENCRYPTED of %lu directories",
-				required_features->encrypted_directories);
-	}
-
-	/* Hard links.  */
-	if (required_features->hard_links && !supported_features->hard_links)
-		WARNING("Extracting %lu hard links as independent files",
-			required_features->hard_links);
+	for (size_t i = 0; i < ARRAY_LEN(feature_warnings); i++) {
+		const struct feature_warning *w = &feature_warnings[i];
+		unsigned long required = *(const unsigned long *)
+			((const u8 *)required_features + w->offset);
+		unsigned long supported = *(const unsigned long *)
+			((const u8 *)supported_features + w->offset);
+
+		if (required && !supported &&
+		    !(extract_flags & w->disable_flags))
+			wimlib_warning(w->msg, required);
+	}
 
 	/* Symbolic links and reparse points.  */
 	if ((extract_flags & WIMLIB_EXTRACT_FLAG_STRICT_SYMLINKS) &&
@@ -1525,13 +1704,21 @@ extract_trees(WIMStruct *wim, struct wim_dentry **trees, size_t num_trees,
 		ctx->progress.extract.target = target;
 	}
 	INIT_LIST_HEAD(&ctx->blob_list);
+	arena_init(&ctx->target_arena);
 	filedes_invalidate(&ctx->tmpfile_fd);
 	ctx->apply_ops = ops;
+	ctx->will_back_from_wim = ops->will_back_from_wim;
 
 	ret = (*ops->get_supported_features)(target, &ctx->supported_features);
 	if (ret)
 		goto out_cleanup;
 
+	/* Cache the feature tests made in per-stream and per-chunk loops.  */
+	ctx->supports_hard_links = ctx->supported_features.hard_links;
+	ctx->supports_named_streams = ctx->supported_features.named_data_streams;
+	ctx->symlinks_as_unix = !ctx->supported_features.reparse_points &&
+				ctx->supported_features.symlink_reparse_points;
+
 	build_dentry_list(&dentry_list, trees, num_trees,
 			  !(extract_flags &
 			    WIMLIB_EXTRACT_FLAG_NO_PRESERVE_DIR_STRUCTURE));
@@ -1552,16 +1739,13 @@ extract_trees(WIMStruct *wim, struct wim_dentry **trees, size_t num_trees,
 		goto out_cleanup;
 	}
 
-	ret = dentry_list_resolve_streams(&dentry_list, ctx);
-	if (ret)
-		goto out_cleanup;
-
-	dentry_list_build_inode_alias_lists(&dentry_list);
-
 	ret = dentry_list_ref_streams(&dentry_list, ctx);
 	if (ret)
 		goto out_cleanup;
 
+	if (!(extract_flags & WIMLIB_EXTRACT_FLAG_FROM_PIPE))
+		sort_planned_blobs(ctx);
+
 	if (extract_flags & WIMLIB_EXTRACT_FLAG_FROM_PIPE) {
 		/* When extracting from a pipe, the number of bytes of data to
 		 * extract can't be determined in the normal way (examining the
@@ -1583,6 +1767,9 @@ extract_trees(WIMStruct *wim, struct wim_dentry **trees, size_t num_trees,
 		}
 	}
 
+	/* The total byte count is now final.  */
+	ctx->progress_step = progress_step(ctx->progress.extract.total_bytes);
+
 	ret = extract_progress(ctx,
 			       ((extract_flags & WIMLIB_EXTRACT_FLAG_IMAGEMODE) ?
 				       WIMLIB_PROGRESS_MSG_EXTRACT_IMAGE_BEGIN :
@@ -1609,8 +1796,9 @@ extract_trees(WIMStruct *wim, struct wim_dentry **trees, size_t num_trees,
 				       WIMLIB_PROGRESS_MSG_EXTRACT_IMAGE_END :
 				       WIMLIB_PROGRESS_MSG_EXTRACT_TREE_END));
 out_cleanup:
-	destroy_blob_list(&ctx->blob_list);
+	destroy_blob_list(ctx);
 	destroy_dentry_list(&dentry_list);
+	FREE(ctx->name_scratch);
 	FREE(ctx);
 out:
 	return ret;
@@ -1639,21 +1827,19 @@ mkdir_if_needed(const tchar *target)
 static int
 check_extract_flags(const WIMStruct *wim, int *extract_flags_p)
 {
+	/* Pairs of extraction flags that must not be specified together  */
+	static const int forbidden_flag_pairs[] = {
+		WIMLIB_EXTRACT_FLAG_NO_ACLS | WIMLIB_EXTRACT_FLAG_STRICT_ACLS,
+		WIMLIB_EXTRACT_FLAG_RPFIX | WIMLIB_EXTRACT_FLAG_NORPFIX,
+	};
 	int extract_flags = *extract_flags_p;
 
 	/* Check for invalid flag combinations  */
 
-	if ((extract_flags &
-	     (WIMLIB_EXTRACT_FLAG_NO_ACLS |
-	      WIMLIB_EXTRACT_FLAG_STRICT_ACLS)) == (WIMLIB_EXTRACT_FLAG_NO_ACLS |
-						    WIMLIB_EXTRACT_FLAG_STRICT_ACLS))
-		return WIMLIB_ERR_INVALID_PARAM;
-
-	if ((extract_flags &
-	     (WIMLIB_EXTRACT_FLAG_RPFIX |
-	      WIMLIB_EXTRACT_FLAG_NORPFIX)) == (WIMLIB_EXTRACT_FLAG_RPFIX |
-						WIMLIB_EXTRACT_FLAG_NORPFIX))
-		return WIMLIB_ERR_INVALID_PARAM;
+	for (size_t i = 0; i < ARRAY_LEN(forbidden_flag_pairs); i++)
+		if ((extract_flags & forbidden_flag_pairs[i]) ==
+		    forbidden_flag_pairs[i])
+			return WIMLIB_ERR_INVALID_PARAM;
 
 #ifndef WITH_NTFS_3G
 	if (extract_flags & WIMLIB_EXTRACT_FLAG_NTFS) {
@@ -1679,12 +1865,11 @@ check_extract_flags(const WIMStruct *wim, int *extract_flags_p)
 			     WIMLIB_EXTRACT_FLAG_COMPACT_LZX))
 	{
 	#ifdef _WIN32
-		int count = 0;
-		count += ((extract_flags & WIMLIB_EXTRACT_FLAG_COMPACT_XPRESS4K) != 0);
-		count += ((extract_flags & WIMLIB_EXTRACT_FLAG_COMPACT_XPRESS8K) != 0);
-		count += ((extract_flags & WIMLIB_EXTRACT_FLAG_COMPACT_XPRESS16K) != 0);
-		count += ((extract_flags & WIMLIB_EXTRACT_FLAG_COMPACT_LZX) != 0);
-		if (count != 1) {
+		if (popcount32(extract_flags &
+			       (WIMLIB_EXTRACT_FLAG_COMPACT_XPRESS4K |
+				WIMLIB_EXTRACT_FLAG_COMPACT_XPRESS8K |
+				WIMLIB_EXTRACT_FLAG_COMPACT_XPRESS16K |
+				WIMLIB_EXTRACT_FLAG_COMPACT_LZX)) != 1) {
 			ERROR("Only one compression format can be specified "
 			      "for compact-mode extraction!");
 			return WIMLIB_ERR_INVALID_PARAM;
@@ -1824,29 +2009,43 @@ do_wimlib_extract_paths(WIMStruct *wim, int image, const tchar *target,
 		trees = append_dentry_ctx.dentries;
 		num_trees = append_dentry_ctx.num_dentries;
 	} else {
+		size_t max_path_nchars = 0;
+		tchar *path_buf;
+
 		trees = MALLOC(num_paths * sizeof(trees[0]));
 		if (trees == NULL)
 			return WIMLIB_ERR_NOMEM;
 
+		/* All the canonicalized paths are only needed transiently, so
+		 * reuse one buffer sized for the longest of them rather than
+		 * making one allocation per path.  */
+		for (size_t i = 0; i < num_paths; i++)
+			max_path_nchars = max(max_path_nchars,
+					      tstrlen(paths[i]));
+
+		path_buf = MALLOC((1 + max_path_nchars + 1) *
+				  sizeof(path_buf[0]));
+		if (path_buf == NULL) {
+			ret = WIMLIB_ERR_NOMEM;
+			goto out_free_trees;
+		}
+
 		for (size_t i = 0; i < num_paths; i++) {
 
-			tchar *path = canonicalize_wim_path(paths[i]);
-			if (path == NULL) {
-				ret = WIMLIB_ERR_NOMEM;
-				goto out_free_trees;
-			}
+			canonicalize_wim_path_into(path_buf, paths[i]);
 
-			trees[i] = get_dentry(wim, path,
+			trees[i] = get_dentry(wim, path_buf,
 					      WIMLIB_CASE_PLATFORM_DEFAULT);
-			FREE(path);
 			if (trees[i] == NULL) {
 				  ERROR("Path \"%"TS"\" does not exist "
 					"in WIM image %d",
 					paths[i], wim->current_image);
 				  ret = WIMLIB_ERR_PATH_DOES_NOT_EXIST;
+				  FREE(path_buf);
 				  goto out_free_trees;
 			}
 		}
+		FREE(path_buf);
 		num_trees = num_paths;
 	}
 
@@ -1870,23 +2069,38 @@ extract_single_image(WIMStruct *wim, int image,
 	return do_wimlib_extract_paths(wim, image, target, &path, 1, extract_flags);
 }
 
-static const tchar * const filename_forbidden_chars =
+/* Is @c forbidden in the name of a directory created from an image name?  */
+static forceinline bool
+filename_char_forbidden(tchar c)
+{
 #ifdef _WIN32
-T("<>:\"/\\|?*");
+	switch (c) {
+	case T('<'): case T('>'): case T(':'): case T('"'):
+	case T('/'): case T('\\'): case T('|'): case T('?'): case T('*'):
+		return true;
+	default:
+		return false;
+	}
 #else
-T("/");
+	return c == T('/');
 #endif
+}
 
 /* This function checks if it is okay to use a WIM image's name as a directory
- * name.  */
+ * name.  The character validation, length limit, and "." / ".." checks are all
+ * made in a single scan of the name.  */
 static bool
 image_name_ok_as_dir(const tchar *image_name)
 {
-	return image_name && *image_name &&
-		!tstrpbrk(image_name, filename_forbidden_chars) &&
-		tstrcmp(image_name, T(".")) &&
-		tstrcmp(image_name, T("..")) &&
-		tstrlen(image_name) <= 128;
+	size_t i;
+
+	if (!image_name || !*image_name)
+		return false;
+	for (i = 0; image_name[i]; i++)
+		if (i >= 128 || filename_char_forbidden(image_name[i]))
+			return false;
+	return !(image_name[0] == T('.') &&
+		 (i == 1 || (i == 2 && image_name[1] == T('.'))));
 }
 
 /* Extracts all images from the WIM to the directory @target, with the images
@@ -1895,7 +2109,7 @@ static int
 extract_all_images(WIMStruct *wim, const tchar *target, int extract_flags)
 {
 	size_t output_path_len = tstrlen(target);
-	tchar buf[output_path_len + 1 + 128 + 1];
+	tchar *buf;
 	int ret;
 	int image;
 	const tchar *image_name;
@@ -1908,6 +2122,14 @@ extract_all_images(WIMStruct *wim, const tchar *target, int extract_flags)
 	ret = mkdir_if_needed(target);
 	if (ret)
 		return ret;
+
+	/* Path buffer sized for the target plus an image name, which
+	 * image_name_ok_as_dir() limits to 128 characters.  The target is
+	 * caller-controlled and may be long, so don't put this on the stack.
+	 */
+	buf = MALLOC((output_path_len + 1 + 128 + 1) * sizeof(tchar));
+	if (!buf)
+		return WIMLIB_ERR_NOMEM;
 	tmemcpy(buf, target, output_path_len);
 	buf[output_path_len] = OS_PREFERRED_PATH_SEPARATOR;
 	for (image = 1; image <= wim->hdr.image_count; image++) {
@@ -1921,9 +2143,10 @@ extract_all_images(WIMStruct *wim, const tchar *target, int extract_flags)
 		}
 		ret = extract_single_image(wim, image, buf, extract_flags);
 		if (ret)
-			return ret;
+			break;
 	}
-	return 0;
+	FREE(buf);
+	return ret;
 }
 
 static int
@@ -171,7 +171,10 @@ inode_get_stream(const struct wim_inode *inode, int stream_type,
 
 	for (unsigned i = 0; i < inode->i_num_streams; i++) {
 		struct wim_inode_stream *strm = &inode->i_streams[i];
+		/* The pointer test skips unnamed streams without the overhead
+		 * of a string comparison against their empty name.  */
 		if (strm->stream_type == stream_type &&
+		    strm->stream_name != NO_STREAM_NAME &&
 		    !cmp_utf16le_strings_z(strm->stream_name, stream_name,
 					   default_ignore_case))
 		{
@@ -127,25 +127,32 @@ do_canonicalize_path(const tchar *in, tchar *out)
 tchar *
 canonicalize_wim_path(const tchar *wim_path)
 {
-	const tchar *in;
-	tchar *out;
 	tchar *result;
 
-	in = wim_path;
-	if (!in)
-		in = T("");
-
-	result = MALLOC((1 + tstrlen(in) + 1) * sizeof(result[0]));
+	result = MALLOC((1 + tstrlen(wim_path ? wim_path : T("")) + 1) *
+			sizeof(result[0]));
 	if (!result)
 		return NULL;
 
-	out = result;
+	canonicalize_wim_path_into(result, wim_path);
+
+	return result;
+}
+
+/* Like canonicalize_wim_path(), but write the result into a caller-provided
+ * buffer, which must have room for 1 + tstrlen(wim_path) + 1 tchars.  */
+void
+canonicalize_wim_path_into(tchar *out, const tchar *wim_path)
+{
+	const tchar *in;
+
+	in = wim_path;
+	if (!in)
+		in = T("");
 
 	/* Add leading slash if missing  */
 	if (!is_any_path_separator(*in))
 		*out++ = WIM_PATH_SEPARATOR;
 
 	do_canonicalize_path(in, out);
-
-	return result;
 }
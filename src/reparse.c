@@ -277,12 +277,17 @@ wim_inode_readlink(const struct wim_inode *inode, char *buf, size_t bufsize,
 	 * link to be relative to that directory.
 	 */
 	if (!link_is_relative_symlink(&link)) {
-		static const char *const nt_root_dirs[] = {
-			"\\??\\", "\\DosDevices\\", "\\Device\\",
+		static const struct {
+			const char *name;
+			size_t len;
+		} nt_root_dirs[] = {
+			{ "\\??\\",		4  },
+			{ "\\DosDevices\\",	12 },
+			{ "\\Device\\",		8  },
 		};
 		for (size_t i = 0; i < ARRAY_LEN(nt_root_dirs); i++) {
-			size_t len = strlen(nt_root_dirs[i]);
-			if (!strncmp(target, nt_root_dirs[i], len)) {
+			size_t len = nt_root_dirs[i].len;
+			if (!strncmp(target, nt_root_dirs[i].name, len)) {
 				char *p = target + len;
 				while (*p == '\\')
 					p++;
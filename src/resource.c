@@ -154,7 +154,6 @@ read_compressed_wim_resource(const struct wim_resource_descriptor * const rdesc,
 	void *cbuf = NULL;
 	bool chunk_offsets_malloced = false;
 	bool ubuf_malloced = false;
-	bool cbuf_malloced = false;
 	struct wimlib_decompressor *decompressor = NULL;
 
 	/* Sanity checks  */
@@ -372,27 +371,29 @@ read_compressed_wim_resource(const struct wim_resource_descriptor * const rdesc,
 			cur_read_offset += chunk_table_size;
 	}
 
-	/* Allocate buffer for holding the uncompressed data of each chunk.  */
-	if (chunk_size <= STACK_MAX) {
+	/* Allocate buffers for holding the uncompressed data of each chunk and
+	 * for reading compressed chunks, which can be at most @chunk_size and
+	 * @chunk_size - 1 bytes respectively.  (Compressed chunks that would be
+	 * a full @chunk_size bytes are actually stored uncompressed.)  Chunks
+	 * too large for the stack (e.g. chunks of solid resources) instead use
+	 * a single heap buffer which, like the decompressor above, is cached in
+	 * the WIMStruct so that it can be reused across resource reads.  */
+	if (likely(chunk_size <= STACK_MAX)) {
 		ubuf = alloca(chunk_size);
-	} else {
-		ubuf = MALLOC(chunk_size);
-		if (unlikely(!ubuf))
-			goto oom;
-		ubuf_malloced = true;
-	}
-
-	/* Allocate a temporary buffer for reading compressed chunks, each of
-	 * which can be at most @chunk_size - 1 bytes.  This excludes compressed
-	 * chunks that are a full @chunk_size bytes, which are actually stored
-	 * uncompressed.  */
-	if (chunk_size - 1 <= STACK_MAX) {
 		cbuf = alloca(chunk_size - 1);
 	} else {
-		cbuf = MALLOC(chunk_size - 1);
-		if (unlikely(!cbuf))
-			goto oom;
-		cbuf_malloced = true;
+		if (chunk_size == rdesc->wim->chunk_buf_size) {
+			/* Cached buffer.  */
+			ubuf = rdesc->wim->chunk_buf;
+			rdesc->wim->chunk_buf_size = 0;
+			rdesc->wim->chunk_buf = NULL;
+		} else {
+			ubuf = MALLOC((size_t)2 * chunk_size - 1);
+			if (unlikely(!ubuf))
+				goto oom;
+		}
+		cbuf = ubuf + chunk_size;
+		ubuf_malloced = true;
 	}
 
 	/* Set current data range.  */
@@ -543,10 +544,11 @@ out_cleanup:
 	}
 	if (chunk_offsets_malloced)
 		FREE(chunk_offsets);
-	if (ubuf_malloced)
-		FREE(ubuf);
-	if (cbuf_malloced)
-		FREE(cbuf);
+	if (ubuf_malloced) {
+		FREE(rdesc->wim->chunk_buf);
+		rdesc->wim->chunk_buf = ubuf;
+		rdesc->wim->chunk_buf_size = chunk_size;
+	}
 	return ret;
 
 oom:
@@ -1021,8 +1023,12 @@ report_sha1_mismatch(struct blob_descriptor *blob,
 	wimlib_assert(blob->blob_location != BLOB_NONEXISTENT);
 	wimlib_assert(blob->blob_location != BLOB_IN_ATTACHED_BUFFER);
 
-	sprint_hash(blob->hash, expected_hashstr);
-	sprint_hash(actual_hash, actual_hashstr);
+	/* Format the hashes only if the messages below will actually be
+	 * printed; the strings are otherwise passed along unread.  */
+	if (wimlib_print_errors) {
+		sprint_hash(blob->hash, expected_hashstr);
+		sprint_hash(actual_hash, actual_hashstr);
+	}
 
 	blob->corrupted = 1;
 
@@ -1201,6 +1207,37 @@ oom:
 	return WIMLIB_ERR_NOMEM;
 }
 
+#ifdef POSIX_FADV_WILLNEED
+/* Let the kernel know that the resource containing the next blob in the list
+ * will be wanted soon, so that its readahead can overlap with the processing
+ * of the current blob.  @advised_rdesc tracks the most recently advised
+ * resource so that blobs packed into one resource don't repeat the advice.  */
+static void
+advise_will_need_next_blob(const struct list_head *next,
+			   const struct list_head *blob_list,
+			   size_t list_head_offset,
+			   const struct wim_resource_descriptor **advised_rdesc)
+{
+	const struct blob_descriptor *blob;
+	const struct wim_resource_descriptor *rdesc;
+
+	if (next == blob_list)
+		return;
+	blob = (const struct blob_descriptor *)
+			((const u8 *)next - list_head_offset);
+	if (blob->blob_location != BLOB_IN_WIM)
+		return;
+	rdesc = blob->rdesc;
+	if (rdesc == *advised_rdesc)
+		return;
+	if (!filedes_is_seekable(&rdesc->wim->in_fd))
+		return;
+	posix_fadvise(rdesc->wim->in_fd.fd, rdesc->offset_in_wim,
+		      rdesc->size_in_wim, POSIX_FADV_WILLNEED);
+	*advised_rdesc = rdesc;
+}
+#endif /* POSIX_FADV_WILLNEED */
+
 /*
  * Read a list of blobs, each of which may be in any supported location (e.g.
  * in a WIM or in an external file).  This function optimizes the case where
@@ -1252,6 +1289,9 @@ read_blob_list(struct list_head *blob_list, size_t list_head_offset,
 	struct blob_descriptor *blob;
 	struct hasher_context *hasher_ctx;
 	struct read_blob_callbacks *sink_cbs;
+#ifdef POSIX_FADV_WILLNEED
+	const struct wim_resource_descriptor *advised_rdesc = NULL;
+#endif
 
 	if (!(flags & BLOB_LIST_ALREADY_SORTED)) {
 		ret = sort_blob_list_by_sequential_order(blob_list,
@@ -1318,6 +1358,11 @@ read_blob_list(struct list_head *blob_list, size_t list_head_offset,
 				 * and @blob_last specifies the last blob in the
 				 * resource that needs to be read.  */
 				next = next2;
+#ifdef POSIX_FADV_WILLNEED
+				advise_will_need_next_blob(next, blob_list,
+							   list_head_offset,
+							   &advised_rdesc);
+#endif
 				ret = read_blobs_in_solid_resource(blob, blob_last,
 								   blob_count,
 								   list_head_offset,
@@ -1329,6 +1374,10 @@ read_blob_list(struct list_head *blob_list, size_t list_head_offset,
 			}
 		}
 
+#ifdef POSIX_FADV_WILLNEED
+		advise_will_need_next_blob(next, blob_list, list_head_offset,
+					   &advised_rdesc);
+#endif
 		ret = read_blob_with_cbs(blob, sink_cbs, flags & RECOVER_DATA);
 		if (unlikely(ret && ret != BEGIN_BLOB_STATUS_SKIP_BLOB))
 			return ret;
@@ -625,18 +625,18 @@ sha1(const void *data, size_t len, u8 hash[SHA1_HASH_SIZE])
 /* "Null" SHA-1 message digest containing all 0's */
 const u8 zero_hash[SHA1_HASH_SIZE];
 
-/* Build a hexadecimal string representation of a SHA-1 message digest. */
+/* Build a hexadecimal string representation of a SHA-1 message digest.
+ * Each nibble is translated through a 16-byte table, so the loop body is
+ * branch-free (no per-nibble 'digit or letter?' comparison).  */
 void
 sprint_hash(const u8 hash[SHA1_HASH_SIZE], tchar strbuf[SHA1_HASH_STRING_LEN])
 {
+	static const char hex_digits[16] = "0123456789abcdef";
 	int i;
-	u8 high, low;
 
 	for (i = 0; i < SHA1_HASH_SIZE; i++) {
-		high = hash[i] >> 4;
-		low = hash[i] & 0xF;
-		strbuf[i * 2 + 0] = (high < 10 ? high + '0' : high - 10 + 'a');
-		strbuf[i * 2 + 1] = (low  < 10 ? low  + '0' : low  - 10 + 'a');
+		strbuf[i * 2 + 0] = hex_digits[hash[i] >> 4];
+		strbuf[i * 2 + 1] = hex_digits[hash[i] & 0xF];
 	}
 	strbuf[i * 2] = 0;
 }
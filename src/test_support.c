@@ -366,8 +366,7 @@ generate_random_security_descriptor(void *_desc, struct generation_context *ctx)
 
 	control = rand16();
 
-	control &= (wimlib_SE_DACL_AUTO_INHERITED |
-		    wimlib_SE_SACL_AUTO_INHERITED);
+	control &= wimlib_SE_AUTO_INHERITED_MASK;
 
 	control |= wimlib_SE_SELF_RELATIVE |
 		   wimlib_SE_DACL_PRESENT |
@@ -30,10 +30,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "wimlib/assert.h"
 #include "wimlib/encoding.h"
 #include "wimlib/error.h"
 #include "wimlib/file_io.h"
 #include "wimlib/textfile.h"
+#include "wimlib/unaligned.h"
 #include "wimlib/util.h"
 
 static int
@@ -112,6 +114,50 @@ read_file_contents(const tchar *path, void **buf_ret, size_t *bufsize_ret)
 	return 0;
 }
 
+/* Guess the encoding of the raw file data: UTF-8 or UTF-16LE.  (Something
+ * weirder and you're out of luck, sorry...)  Returns the encoding and the
+ * offset of the actual text past any byte order mark.  */
+static void
+detect_text_encoding(const u8 *buf_raw, size_t bufsize_raw,
+		     bool *utf8_ret, size_t *offset_raw_ret)
+{
+	/* The default: UTF-8 with no byte order mark  */
+	*utf8_ret = true;
+	*offset_raw_ret = 0;
+
+	if (bufsize_raw < 2)
+		return;
+
+	/* All the signatures are decided by the first two bytes; load them
+	 * once.  As a little-endian value, the UTF-16LE BOM (FF FE) is 0xFEFF,
+	 * and a leading ASCII UTF-16LE code unit (xx 00 with xx <= 0x7F) is a
+	 * value <= 0x7F.  */
+	const u16 start = get_unaligned_le16(buf_raw);
+
+	switch (start) {
+	case 0xFEFF:		/* UTF-16LE with byte order mark  */
+		*utf8_ret = false;
+		*offset_raw_ret = 2;
+		break;
+	case 0xBBEF:		/* Possible UTF-8 byte order mark (EF BB BF)  */
+		if (bufsize_raw >= 3 && buf_raw[2] == 0xBF)
+			*offset_raw_ret = 3;
+		break;
+	default:
+		if (start <= 0x7F)
+			*utf8_ret = false;	/* UTF-16LE, no byte order mark  */
+		break;
+	}
+}
+
+/* Does text in the given encoding match the tchar encoding, so that
+ * "converting" it is just a copy?  */
+static forceinline bool
+conversion_is_identity(bool utf8)
+{
+	return utf8 == !TCHAR_IS_UTF16LE;
+}
+
 static int
 translate_text_buffer(const u8 *buf_raw, size_t bufsize_raw,
 		      tchar **tstr_ret, size_t *tstr_nchars_ret)
@@ -122,35 +168,7 @@ translate_text_buffer(const u8 *buf_raw, size_t bufsize_raw,
 	size_t bufsize_tstr;
 	int ret;
 
-	/* Guess the encoding: UTF-8 or UTF-16LE.  (Something weirder and you're
-	 * out of luck, sorry...)  */
-	if (bufsize_raw >= 2 &&
-	    buf_raw[0] == 0xFF &&
-	    buf_raw[1] == 0xFE)
-	{
-		utf8 = false;
-		offset_raw = 2;
-	}
-	else if (bufsize_raw >= 2 &&
-		 buf_raw[0] <= 0x7F &&
-		 buf_raw[1] == 0x00)
-	{
-		utf8 = false;
-		offset_raw = 0;
-	}
-	else if (bufsize_raw >= 3 &&
-		 buf_raw[0] == 0xEF &&
-		 buf_raw[1] == 0xBB &&
-		 buf_raw[2] == 0xBF)
-	{
-		utf8 = true;
-		offset_raw = 3;
-	}
-	else
-	{
-		utf8 = true;
-		offset_raw = 0;
-	}
+	detect_text_encoding(buf_raw, bufsize_raw, &utf8, &offset_raw);
 
 	if (utf8) {
 		ret = utf8_to_tstr((const char *)(buf_raw + offset_raw),
@@ -169,6 +187,44 @@ translate_text_buffer(const u8 *buf_raw, size_t bufsize_raw,
 	return 0;
 }
 
+/* Like translate_text_buffer(), but take ownership of @buf_raw, which must be
+ * a heap buffer.  When the text is already in the tchar encoding this avoids
+ * the full-buffer copy that tstr_to_tstr() would make: the buffer is reused in
+ * place, with REALLOC() claiming room for the null terminator (usually without
+ * moving the block).  @buf_raw is consumed even on failure.  */
+static int
+translate_text_buffer_owned(void *buf_raw, size_t bufsize_raw,
+			    tchar **tstr_ret, size_t *tstr_nchars_ret)
+{
+	size_t offset_raw;
+	bool utf8;
+	int ret;
+
+	detect_text_encoding(buf_raw, bufsize_raw, &utf8, &offset_raw);
+
+	if (conversion_is_identity(utf8)) {
+		size_t nbytes = bufsize_raw - offset_raw;
+		tchar *buf_tstr;
+
+		if (offset_raw)
+			memmove(buf_raw, (u8 *)buf_raw + offset_raw, nbytes);
+		buf_tstr = REALLOC(buf_raw, nbytes + sizeof(tchar));
+		if (!buf_tstr) {
+			FREE(buf_raw);
+			return WIMLIB_ERR_NOMEM;
+		}
+		buf_tstr[nbytes / sizeof(tchar)] = 0;
+		*tstr_ret = buf_tstr;
+		*tstr_nchars_ret = nbytes / sizeof(tchar);
+		return 0;
+	}
+
+	ret = translate_text_buffer(buf_raw, bufsize_raw,
+				    tstr_ret, tstr_nchars_ret);
+	FREE(buf_raw);
+	return ret;
+}
+
 static int
 string_list_append(struct string_list *list, tchar *str)
 {
@@ -177,8 +233,17 @@ string_list_append(struct string_list *list, tchar *str)
 	if (list->num_strings == num_alloc_strings) {
 		tchar **new_strings;
 
-		num_alloc_strings = max(num_alloc_strings * 3 / 2,
-					num_alloc_strings + 4);
+		/* Start with room for a useful number of lines and double from
+		 * there, so that a file with thousands of lines costs a dozen
+		 * reallocations rather than hundreds; back off to 1.5x growth
+		 * once the array is large enough that doubling would
+		 * overcommit.  */
+		if (num_alloc_strings < 16)
+			num_alloc_strings = 16;
+		else if (num_alloc_strings < 4096)
+			num_alloc_strings *= 2;
+		else
+			num_alloc_strings += num_alloc_strings / 2;
 		new_strings = REALLOC(list->strings,
 				      sizeof(list->strings[0]) * num_alloc_strings);
 		if (!new_strings)
@@ -190,6 +255,20 @@ string_list_append(struct string_list *list, tchar *str)
 	return 0;
 }
 
+/* Whitespace characters accepted by istspace() in the C locale.  They are all
+ * ASCII, so one table serves both tchar widths; no non-ASCII character is
+ * treated as whitespace.  Inlining the classification avoids a call into the
+ * locale machinery for every character scanned by the trim loops.  */
+static const u8 ws_class[128] = {
+	['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1,
+};
+
+static forceinline bool
+is_ws(tchar c)
+{
+	return (u32)c < 128 && ws_class[(u32)c];
+}
+
 #define NOT_IN_SECTION		-1
 #define IN_UNKNOWN_SECTION	-2
 
@@ -204,6 +283,10 @@ parse_text_file(const tchar *path, tchar *buf, size_t buflen,
 	tchar *nl;
 	unsigned long line_no = 1;
 
+	/* The caller must terminate the buffer with a newline (load_text_file()
+	 * appends one), so the newline search below can never fail.  */
+	wimlib_assert(buflen > 0 && buf[buflen - 1] == T('\n'));
+
 	for (int i = 0; i < num_pos_sections; i++) {
 		if (*pos_sections[i].name)
 			have_named_sections = true;
@@ -217,18 +300,16 @@ parse_text_file(const tchar *path, tchar *buf, size_t buflen,
 		int ret;
 
 		nl = tmemchr(p, T('\n'), buf + buflen - p);
-		if (!nl)
-			break;
 
 		line_begin = p;
 		line_end = nl;
 
 		/* Ignore leading whitespace.  */
-		while (line_begin < nl && istspace(*line_begin))
+		while (line_begin < nl && is_ws(*line_begin))
 			line_begin++;
 
 		/* Ignore trailing whitespace.  */
-		while (line_end > line_begin && istspace(*(line_end - 1)))
+		while (line_end > line_begin && is_ws(*(line_end - 1)))
 			line_end--;
 
 		line_len = line_end - line_begin;
@@ -244,17 +325,24 @@ parse_text_file(const tchar *path, tchar *buf, size_t buflen,
 		    line_begin[line_len - 1] == T(']') &&
 		    have_named_sections)
 		{
-			line_begin[line_len - 1] = T('\0');
+			/* Compare the text between the brackets against each
+			 * section name with a length-bounded compare, rather
+			 * than temporarily replacing the ']' with a null
+			 * terminator: no stores into the line, and it stays
+			 * intact for the warning below.  */
+			const size_t name_len = line_len - 2;
+
 			current_section = IN_UNKNOWN_SECTION;
 			for (int i = 0; i < num_pos_sections; i++) {
-				if (!tstrcmp(line_begin + 1,
-					     pos_sections[i].name))
+				const tchar *name = pos_sections[i].name;
+
+				if (tstrlen(name) == name_len &&
+				    !tmemcmp(line_begin + 1, name, name_len))
 				{
 					current_section = i;
 					break;
 				}
 			}
-			line_begin[line_len - 1] = T(']');
 			if (current_section < 0) {
 				if (!(flags & LOAD_TEXT_FILE_NO_WARNINGS)) {
 					WARNING("%"TS":%lu: Unrecognized section \"%"TS"\"",
@@ -275,16 +363,20 @@ parse_text_file(const tchar *path, tchar *buf, size_t buflen,
 		}
 
 		if (flags & LOAD_TEXT_FILE_REMOVE_QUOTES) {
-			if (line_begin[0] == T('"') || line_begin[0] == T('\'')) {
-				tchar quote = line_begin[0];
-				if (line_len >= 2 &&
-				    line_begin[line_len - 1] == quote)
-				{
-					line_begin++;
-					line_len -= 2;
-					line_begin[line_len] = T('\0');
-				}
-			}
+			const tchar first = line_begin[0];
+			const bool quoted = (first == T('"') ||
+					     first == T('\'')) &&
+					    line_len >= 2 &&
+					    line_begin[line_len - 1] == first;
+
+			/* Strip the quotes arithmetically rather than in a
+			 * nest of data-dependent branches.  The store is
+			 * unconditional: it overwrites the closing quote if
+			 * the line was quoted, and rewrites the existing null
+			 * terminator if it wasn't.  */
+			line_begin += quoted;
+			line_len -= 2 * quoted;
+			line_begin[line_len] = T('\0');
 		}
 
 		if (mangle_line) {
@@ -359,14 +451,19 @@ load_text_file(const tchar *path, const void *buf, size_t bufsize,
 			ret = read_file_contents(path, (void **)&buf, &bufsize);
 		if (ret)
 			return ret;
+		ret = translate_text_buffer_owned((void *)buf, bufsize,
+						  &tstr, &tstr_nchars);
+	} else {
+		ret = translate_text_buffer(buf, bufsize, &tstr, &tstr_nchars);
 	}
-
-	ret = translate_text_buffer(buf, bufsize, &tstr, &tstr_nchars);
-	if (is_filemode)
-		FREE((void *)buf);
 	if (ret)
 		return ret;
 
+	/* Guarantee the last line is newline-terminated.  This write is
+	 * in-bounds: every path that produced @tstr (the string converters as
+	 * well as translate_text_buffer_owned()) allocates one tchar beyond
+	 * the returned length for a null terminator, which is what is
+	 * overwritten here.  */
 	tstr[tstr_nchars++] = T('\n');
 
 	ret = parse_text_file(is_stdin ? T("<stdin>") : path,
@@ -398,7 +495,6 @@ wimlib_load_text_file(const tchar *path,
 		ret = read_file_contents(path, &buf, &bufsize);
 	if (ret)
 		return ret;
-	ret = translate_text_buffer(buf, bufsize, tstr_ret, tstr_nchars_ret);
-	FREE(buf);
-	return ret;
+	return translate_text_buffer_owned(buf, bufsize,
+					   tstr_ret, tstr_nchars_ret);
 }
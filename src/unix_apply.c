@@ -79,6 +79,9 @@ struct unix_apply_ctx {
 	/* Buffers for building extraction paths (allocated).  */
 	char *pathbufs[NUM_PATHBUFS];
 
+	/* Size of each buffer in pathbufs[], in bytes  */
+	size_t path_max;
+
 	/* Index of next pathbuf to use  */
 	unsigned which_pathbuf;
 
@@ -99,6 +102,20 @@ struct unix_apply_ctx {
 	/* Buffer for reading reparse point data into memory  */
 	u8 reparse_data[REPARSE_DATA_MAX_SIZE];
 
+	/* Buffer for building symbolic link targets.  This lives in the
+	 * (heap-allocated) context rather than on the stack because it must be
+	 * large enough for a maximum-size reparse point.  */
+	char symlink_target[REPARSE_POINT_MAX_SIZE];
+
+	/* Memoization of the translated link target in symlink_target for the
+	 * reparse blob currently being extracted.  Many links can share one
+	 * reparse blob (e.g. WinSxS junctions); the translation additionally
+	 * depends only on the inode fields mirrored here.
+	 * cached_rp_target_len is -1 when nothing is cached.  */
+	u32 cached_rp_reparse_tag;
+	u16 cached_rp_flags;
+	int cached_rp_target_len;
+
 	/* Pointer to the next byte in @reparse_data to fill  */
 	u8 *reparse_ptr;
 
@@ -109,6 +126,10 @@ struct unix_apply_ctx {
 	/* Number of characters in target_abspath.  */
 	size_t target_abspath_nchars;
 
+	/* Whether WIMLIB_EXTRACT_FLAG_UNIX_DATA was given; tested once per
+	 * extracted inode, so cached out of extract_flags  */
+	bool unix_data;
+
 	/* Number of special files we couldn't create due to EPERM  */
 	unsigned long num_special_files_ignored;
 };
@@ -165,8 +186,11 @@ unix_build_extraction_path(const struct wim_dentry *dentry,
 	pathbuf = ctx->pathbufs[ctx->which_pathbuf];
 	ctx->which_pathbuf = (ctx->which_pathbuf + 1) % NUM_PATHBUFS;
 
-	p = &pathbuf[ctx->common.target_nchars +
-		     unix_dentry_path_length(dentry)];
+	/* Build the path right-aligned in the buffer, walking the ancestor
+	 * chain only once, then prepend the path to the target directory.
+	 * (Computing the exact length first, as unix_compute_path_max() does,
+	 * would chase the same ancestor pointers a second time.)  */
+	p = &pathbuf[ctx->path_max - 1];
 	*p = '\0';
 	d = dentry;
 	do {
@@ -178,7 +202,9 @@ unix_build_extraction_path(const struct wim_dentry *dentry,
 		d = d->d_parent;
 	} while (!dentry_is_root(d) && will_extract_dentry(d));
 
-	return pathbuf;
+	p -= ctx->common.target_nchars;
+	memcpy(p, ctx->common.target, ctx->common.target_nchars);
+	return p;
 }
 
 /* This causes the next call to unix_build_extraction_path() to use the same
@@ -441,7 +467,7 @@ unix_set_metadata(int fd, const struct wim_inode *inode,
 	if (fd < 0 && !path)
 		path = unix_build_inode_extraction_path(inode, ctx);
 
-	if (ctx->common.extract_flags & WIMLIB_EXTRACT_FLAG_UNIX_DATA) {
+	if (ctx->unix_data) {
 		ret = apply_unix_metadata(fd, inode, path, ctx);
 		if (ret)
 			return ret;
@@ -540,7 +566,7 @@ unix_extract_if_empty_file(const struct wim_dentry *dentry,
 		return 0;
 
 	/* Recognize special files in UNIX_DATA mode  */
-	if ((ctx->common.extract_flags & WIMLIB_EXTRACT_FLAG_UNIX_DATA) &&
+	if (ctx->unix_data &&
 	    inode_get_unix_data(inode, &unix_data) &&
 	    !S_ISREG(unix_data.mode))
 	{
@@ -640,22 +666,33 @@ static int
 unix_create_symlink(const struct wim_inode *inode, const char *path,
 		    size_t rpdatalen, struct unix_apply_ctx *ctx)
 {
-	char target[REPARSE_POINT_MAX_SIZE];
-	struct blob_descriptor blob_override;
+	char *target = ctx->symlink_target;
 	int ret;
 
-	blob_set_is_located_in_attached_buffer(&blob_override,
-					       ctx->reparse_data, rpdatalen);
-
-	ret = wim_inode_readlink(inode, target, sizeof(target) - 1,
-				 &blob_override,
-				 ctx->target_abspath,
-				 ctx->target_abspath_nchars);
-	if (unlikely(ret < 0)) {
-		errno = -ret;
-		return WIMLIB_ERR_READLINK;
+	if (ctx->cached_rp_target_len < 0 ||
+	    ctx->cached_rp_reparse_tag != inode->i_reparse_tag ||
+	    ctx->cached_rp_flags != inode->i_rp_flags)
+	{
+		struct blob_descriptor blob_override;
+
+		blob_set_is_located_in_attached_buffer(&blob_override,
+						       ctx->reparse_data,
+						       rpdatalen);
+
+		ret = wim_inode_readlink(inode, target,
+					 sizeof(ctx->symlink_target) - 1,
+					 &blob_override,
+					 ctx->target_abspath,
+					 ctx->target_abspath_nchars);
+		if (unlikely(ret < 0)) {
+			errno = -ret;
+			return WIMLIB_ERR_READLINK;
+		}
+		target[ret] = '\0';
+		ctx->cached_rp_reparse_tag = inode->i_reparse_tag;
+		ctx->cached_rp_flags = inode->i_rp_flags;
+		ctx->cached_rp_target_len = ret;
 	}
-	target[ret] = '\0';
 
 retry_symlink:
 	if (symlink(target, path)) {
@@ -736,6 +773,9 @@ unix_begin_extract_blob(struct blob_descriptor *blob, void *_ctx)
 	struct unix_apply_ctx *ctx = _ctx;
 	const struct blob_extraction_target *targets = blob_extraction_targets(blob);
 
+	/* New blob, so any memoized symlink target translation is stale.  */
+	ctx->cached_rp_target_len = -1;
+
 	for (u32 i = 0; i < blob->out_refcnt; i++) {
 		int ret = unix_begin_extract_blob_instance(blob,
 							   targets[i].inode,
@@ -882,20 +922,20 @@ unix_extract(struct list_head *dentry_list, struct apply_ctx *_ctx)
 	u64 dir_count;
 	u64 empty_file_count;
 
+	ctx->unix_data = (ctx->common.extract_flags &
+			  WIMLIB_EXTRACT_FLAG_UNIX_DATA);
+
 	/* Compute the maximum path length that will be needed, then allocate
 	 * some path buffers.  */
 	path_max = unix_compute_path_max(dentry_list, ctx);
 
+	ctx->path_max = path_max;
 	for (unsigned i = 0; i < NUM_PATHBUFS; i++) {
 		ctx->pathbufs[i] = MALLOC(path_max);
 		if (!ctx->pathbufs[i]) {
 			ret = WIMLIB_ERR_NOMEM;
 			goto out;
 		}
-		/* Pre-fill the target in each path buffer.  We'll just append
-		 * the rest of the paths after this.  */
-		memcpy(ctx->pathbufs[i],
-		       ctx->common.target, ctx->common.target_nchars);
 	}
 
 	/* Extract directories and empty regular files.  Directories are needed
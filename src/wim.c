@@ -232,21 +232,27 @@ put_image_metadata(struct wim_image_metadata *imd)
 int
 append_image_metadata(WIMStruct *wim, struct wim_image_metadata *imd)
 {
-	struct wim_image_metadata **imd_array;
-
 	if (!wim_has_metadata(wim))
 		return WIMLIB_ERR_METADATA_NOT_FOUND;
 
 	if (wim->hdr.image_count >= MAX_IMAGES)
 		return WIMLIB_ERR_IMAGE_COUNT;
 
-	imd_array = REALLOC(wim->image_metadata,
-			    sizeof(wim->image_metadata[0]) * (wim->hdr.image_count + 1));
+	/* Grow the array geometrically so that appending N images requires
+	 * only O(N) amortized work rather than O(N^2).  */
+	if (wim->hdr.image_count == wim->image_metadata_capacity) {
+		unsigned new_capacity = wim->image_metadata_capacity ?
+					wim->image_metadata_capacity * 2 : 8;
+		struct wim_image_metadata **imd_array;
 
-	if (!imd_array)
-		return WIMLIB_ERR_NOMEM;
-	wim->image_metadata = imd_array;
-	imd_array[wim->hdr.image_count++] = imd;
+		imd_array = REALLOC(wim->image_metadata,
+				    sizeof(wim->image_metadata[0]) * new_capacity);
+		if (!imd_array)
+			return WIMLIB_ERR_NOMEM;
+		wim->image_metadata = imd_array;
+		wim->image_metadata_capacity = new_capacity;
+	}
+	wim->image_metadata[wim->hdr.image_count++] = imd;
 	return 0;
 }
 
@@ -751,6 +757,7 @@ begin_read(WIMStruct *wim, const void *wim_filename_or_fd, int open_flags)
 					     sizeof(wim->image_metadata[0]));
 		if (!wim->image_metadata)
 			return WIMLIB_ERR_NOMEM;
+		wim->image_metadata_capacity = wim->hdr.image_count;
 	}
 
 	if (open_flags & WIMLIB_OPEN_FLAG_FROM_PIPE) {
@@ -905,6 +912,7 @@ wim_decrement_refcnt(WIMStruct *wim)
 	if (filedes_valid(&wim->out_fd))
 		filedes_close(&wim->out_fd);
 	wimlib_free_decompressor(wim->decompressor);
+	FREE(wim->chunk_buf);
 	xml_free_info_struct(wim->xml_info);
 	FREE(wim->filename);
 	FREE(wim);
@@ -949,6 +957,13 @@ wimlib_get_version_string(void)
 	return T(PACKAGE_VERSION);
 }
 
+/*
+ * 'lib_initialized' is read outside 'lib_initialization_mutex' as a fast path,
+ * so it must be accessed with acquire/release semantics to guarantee that a
+ * thread which observes it set also observes the initialized globals (upcase
+ * table, cpu_features, etc.).  A plain read would be a data race and could
+ * reorder on weakly ordered CPUs.
+ */
 static bool lib_initialized = false;
 static struct mutex lib_initialization_mutex = MUTEX_INITIALIZER;
 
@@ -958,7 +973,7 @@ wimlib_global_init(int init_flags)
 {
 	int ret = 0;
 
-	if (lib_initialized)
+	if (__atomic_load_n(&lib_initialized, __ATOMIC_ACQUIRE))
 		goto out;
 
 	mutex_lock(&lib_initialization_mutex);
@@ -996,7 +1011,7 @@ wimlib_global_init(int init_flags)
 		default_ignore_case = false;
 	else if (init_flags & WIMLIB_INIT_FLAG_DEFAULT_CASE_INSENSITIVE)
 		default_ignore_case = true;
-	lib_initialized = true;
+	__atomic_store_n(&lib_initialized, true, __ATOMIC_RELEASE);
 	ret = 0;
 out_unlock:
 	mutex_unlock(&lib_initialization_mutex);
@@ -1008,7 +1023,7 @@ out:
 WIMLIBAPI void
 wimlib_global_cleanup(void)
 {
-	if (!lib_initialized)
+	if (!__atomic_load_n(&lib_initialized, __ATOMIC_ACQUIRE))
 		return;
 
 	mutex_lock(&lib_initialization_mutex);
@@ -1021,7 +1036,7 @@ wimlib_global_cleanup(void)
 #endif
 
 	wimlib_set_error_file(NULL);
-	lib_initialized = false;
+	__atomic_store_n(&lib_initialized, false, __ATOMIC_RELEASE);
 
 out_unlock:
 	mutex_unlock(&lib_initialization_mutex);
@@ -118,6 +118,10 @@ struct win32_apply_ctx {
 	 * and junctions  */
 	struct reparse_buffer_disk rpfixbuf;
 
+	/* Whether WIMLIB_EXTRACT_FLAG_RPFIX was given; tested once per reparse
+	 * point extracted, so cached out of extract_flags  */
+	bool rpfix;
+
 	/* Array of open handles to filesystem streams currently being written
 	 */
 	HANDLE open_handles[MAX_OPEN_FILES];
@@ -929,14 +933,15 @@ static void
 build_extraction_path(const struct wim_dentry *dentry,
 		      struct win32_apply_ctx *ctx)
 {
-	size_t len;
-	wchar_t *p;
+	wchar_t * const end = ctx->pathbuf.Buffer +
+			      (ctx->pathbuf.MaximumLength / sizeof(wchar_t));
+	wchar_t *p = end;
 	const struct wim_dentry *d;
 
-	len = dentry_extraction_path_length(dentry);
-
-	ctx->pathbuf.Length = len * sizeof(wchar_t);
-	p = ctx->pathbuf.Buffer + len;
+	/* Build the path right-aligned in the buffer, walking the ancestor
+	 * chain only once, then slide it to the front.  (Computing the exact
+	 * length first, as dentry_extraction_path_length() does, would chase
+	 * the same ancestor pointers a second time.)  */
 	for (d = dentry;
 	     !dentry_is_root(d->d_parent) && will_extract_dentry(d->d_parent);
 	     d = d->d_parent)
@@ -950,6 +955,9 @@ build_extraction_path(const struct wim_dentry *dentry,
 	/* No leading slash  */
 	p -= d->d_extraction_name_nchars;
 	wmemcpy(p, d->d_extraction_name, d->d_extraction_name_nchars);
+
+	ctx->pathbuf.Length = (end - p) * sizeof(wchar_t);
+	memmove(ctx->pathbuf.Buffer, p, ctx->pathbuf.Length);
 }
 
 /* Build the path at which to extract the @dentry, relative to the target
@@ -1010,10 +1018,10 @@ build_win32_extraction_path(const struct wim_dentry *dentry,
 static const wchar_t *
 current_path(struct win32_apply_ctx *ctx)
 {
-	wchar_t *p = ctx->print_buffer;
+	/* The fixed "target\" prefix was filled in by prepare_target(), so
+	 * only the relative path needs to be appended here.  */
+	wchar_t *p = ctx->print_buffer + ctx->common.target_nchars + 1;
 
-	p = wmempcpy(p, ctx->common.target, ctx->common.target_nchars);
-	*p++ = L'\\';
 	p = wmempcpy(p, ctx->pathbuf.Buffer, ctx->pathbuf.Length / sizeof(wchar_t));
 	*p = L'\0';
 	return ctx->print_buffer;
@@ -1107,6 +1115,11 @@ prepare_target(struct list_head *dentry_list, struct win32_apply_ctx *ctx)
 	if (!ctx->print_buffer)
 		return WIMLIB_ERR_NOMEM;
 
+	/* Pre-fill the fixed "target\" prefix of the print buffer; see
+	 * current_path().  */
+	wmemcpy(ctx->print_buffer, ctx->common.target, ctx->common.target_nchars);
+	ctx->print_buffer[ctx->common.target_nchars] = L'\\';
+
 	return 0;
 }
 
@@ -2207,8 +2220,13 @@ try_rpfix(struct reparse_buffer_disk *rpbuf, u16 *rpbuflen_p,
 
 	wchar_t fixed_subst_name[fixed_subst_name_nchars];
 
-	wmemcpy(fixed_subst_name, ctx->target_ntpath.Buffer, target_ntpath_nchars);
-	wmemcpy(&fixed_subst_name[target_ntpath_nchars], relpath, relpath_nchars);
+	/* Copy with byte counts rather than wmemcpy(): the CRT's wmemcpy() may
+	 * copy a wide character at a time, while memcpy() uses full-width
+	 * vector loads and stores.  */
+	memcpy(fixed_subst_name, ctx->target_ntpath.Buffer,
+	       target_ntpath_nchars * sizeof(wchar_t));
+	memcpy(&fixed_subst_name[target_ntpath_nchars], relpath,
+	       relpath_nchars * sizeof(wchar_t));
 	/* Doesn't need to be null-terminated.  */
 
 	/* Print name should be Win32, but not all NT names can even be
@@ -2235,8 +2253,8 @@ set_reparse_point(const struct wim_dentry *dentry,
 		  const struct reparse_buffer_disk *rpbuf, u16 rpbuflen,
 		  struct win32_apply_ctx *ctx)
 {
-	if ((ctx->common.extract_flags & WIMLIB_EXTRACT_FLAG_RPFIX)
-	    && !(dentry->d_inode->i_rp_flags & WIM_RP_FLAG_NOT_FIXED))
+	if (ctx->rpfix &&
+	    !(dentry->d_inode->i_rp_flags & WIM_RP_FLAG_NOT_FIXED))
 	{
 		memcpy(&ctx->rpfixbuf, rpbuf, rpbuflen);
 		try_rpfix(&ctx->rpfixbuf, &rpbuflen, ctx);
@@ -3275,6 +3293,8 @@ win32_extract(struct list_head *dentry_list, struct apply_ctx *_ctx)
 	struct win32_apply_ctx *ctx = (struct win32_apply_ctx *)_ctx;
 	u64 dentry_count;
 
+	ctx->rpfix = (ctx->common.extract_flags & WIMLIB_EXTRACT_FLAG_RPFIX);
+
 	ret = prepare_target(dentry_list, ctx);
 	if (ret)
 		goto out;
@@ -56,6 +56,11 @@ struct wim_xml_info {
 
 	/* The number of WIM images (the length of 'images')  */
 	int image_count;
+
+	/* The allocated length of the 'images' array, in entries.  Extra slack
+	 * allows IMAGE elements to be appended without reallocating the array
+	 * every time.  */
+	int image_capacity;
 };
 
 static u64
@@ -355,13 +360,20 @@ append_image_node(struct wim_xml_info *info, struct xml_node *image_node)
 	if (ret)
 		return ret;
 
-	/* Append the IMAGE element to the 'images' array.  */
-	images = REALLOC(info->images,
-			 (info->image_count + 1) * sizeof(info->images[0]));
-	if (unlikely(!images))
-		return WIMLIB_ERR_NOMEM;
-	info->images = images;
-	images[info->image_count++] = image_node;
+	/* Append the IMAGE element to the 'images' array, growing the array
+	 * geometrically so that N appends take amortized O(N) time.  */
+	if (info->image_count == info->image_capacity) {
+		int new_capacity = info->image_capacity ?
+				   info->image_capacity * 2 : 4;
+
+		images = REALLOC(info->images,
+				 new_capacity * sizeof(info->images[0]));
+		if (unlikely(!images))
+			return WIMLIB_ERR_NOMEM;
+		info->images = images;
+		info->image_capacity = new_capacity;
+	}
+	info->images[info->image_count++] = image_node;
 
 	/* Add the IMAGE element to the document.  */
 	xml_add_child(info->root, image_node);
@@ -858,6 +870,7 @@ setup_images(struct wim_xml_info *info, struct xml_node *root)
 	info->images = CALLOC(info->image_count, sizeof(info->images[0]));
 	if (unlikely(!info->images))
 		goto err;
+	info->image_capacity = info->image_count;
 	xml_node_for_each_child(root, child) {
 		if (!xml_node_is_element(child, T("IMAGE")))
 			continue;